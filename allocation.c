@@ -1,50 +1,348 @@
 #include "allocation.h"
+#include "functions.h"
 
 
-processor_struct *initialize_processor(){
+processor_struct *initialize_processor(int total_cores, int total_levels){
     processor_struct *processor = (processor_struct *)malloc(sizeof(processor_struct));
     int i;
 
-    processor->total_cores = NUM_CORES;
+    processor->total_cores = total_cores;
+    processor->total_levels = total_levels;
+    processor->crit_level = 0;
+    processor->mode_switch_cluster = 0;
+    processor->governor = DVFS_NONE;
+    processor->shutdown_threshold = -1;
+    processor->allocation = ALLOCATION_FILE;
+    processor->continue_on_miss = 0;
+    processor->migration = MIGRATION_NONE;
+    processor->threads = 1;
+    processor->discarded_pool = (job_queue_struct *)calloc(1, sizeof(job_queue_struct));
+    pthread_mutex_init(&processor->discarded_lock, NULL);
     processor->cores = malloc(sizeof(core_struct) * (processor->total_cores));
+    processor->event_calendar = NULL;
+    processor->arrival_position = NULL;
+    processor->output_file = NULL;
+    processor->stats = NULL;
+    atomic_init(&processor->trace_draining, 0);
 
     for (i = 0; i < processor->total_cores; i++)
     {
         processor->cores[i].ready_queue = (job_queue_struct *)malloc(sizeof(job_queue_struct));
         processor->cores[i].ready_queue->num_jobs = 0;
         processor->cores[i].ready_queue->job_list_head = NULL;
+        processor->cores[i].ready_queue->num_inserted = 0;
         processor->cores[i].local_discarded_queue = (job_queue_struct *)malloc(sizeof(job_queue_struct));
         processor->cores[i].local_discarded_queue->num_jobs = 0;
         processor->cores[i].local_discarded_queue->job_list_head = NULL;
+        processor->cores[i].local_discarded_queue->num_inserted = 0;
+        processor->cores[i].local_discarded_queue->slack_cache = NULL;
         processor->cores[i].curr_exec_job = NULL;
-        processor->cores[i].total_time = 0.0f;
-        processor->cores[i].total_idle_time = 0.0f;
+        processor->cores[i].crit_level = 0;
+        processor->cores[i].total_time = 0;
+        processor->cores[i].total_idle_time = 0;
         processor->cores[i].state = ACTIVE;
         processor->cores[i].is_shutdown = -1;
         processor->cores[i].frequency = 1.00;
+        processor->cores[i].dvfs_util = 0.00;
+        processor->cores[i].dvfs_boost = 0;
         processor->cores[i].x_factor = 0.00;
         processor->cores[i].threshold_crit_lvl = -1;
-        processor->cores[i].next_invocation_time = INT_MAX;
+        processor->cores[i].next_invocation_time = TICK_MAX;
+        processor->cores[i].arrival_calendar = NULL;
+        processor->cores[i].released_tasks = NULL;
+        processor->cores[i].task_index = NULL;
+        processor->cores[i].level_index = NULL;
+        processor->cores[i].job_pool = initialize_job_pool();
+        processor->cores[i].trace = NULL;
+        processor->cores[i].slack_cache = (slack_cache_struct *)calloc(1, sizeof(slack_cache_struct));
+        processor->cores[i].ready_queue->slack_cache = processor->cores[i].slack_cache;
 
-        processor->cores[i].rem_util = (double *)malloc(sizeof(double) * MAX_CRITICALITY_LEVELS);
-        for (int j = 0; j < MAX_CRITICALITY_LEVELS; j++)
+        processor->cores[i].rem_util = (double *)malloc(sizeof(double) * total_levels);
+        for (int j = 0; j < total_levels; j++)
         {
             processor->cores[i].rem_util[j] = 1.00;
         }
+        processor->cores[i].utilisation = (double *)calloc(total_levels * total_levels, sizeof(double));
+        processor->cores[i].num_tasks_allocated = 0;
     }
 
     return processor;
 }
 
-int allocate_tasks_to_cores(task_set_struct *task_set, processor_struct *processor)
+int find_total_cores(char *cores_file_name)
 {
+    FILE *cores_file;
+    double x_factor;
+    int threshold_crit_lvl;
+    int total_cores = 0;
+
+    cores_file = fopen(cores_file_name, "r");
+    if (cores_file == NULL)
+        return 0;
+    while (fscanf(cores_file, "%lf%d", &x_factor, &threshold_crit_lvl) == 2)
+    {
+        total_cores++;
+    }
+    fclose(cores_file);
+
+    return total_cores;
+}
+
+/*
+    Function to set the options of the simulation on the processor.
+*/
+void set_processor_options(processor_struct *processor, options_struct *options)
+{
+    processor->allocation = options->allocation;
+    processor->governor = options->governor;
+    processor->shutdown_threshold = options->shutdown_threshold;
+    processor->continue_on_miss = options->continue_on_miss;
+    processor->migration = options->migration;
+    processor->mode_switch_cluster = options->mode_switch_cluster;
+    processor->threads = options->threads;
+}
+
+/*
+    Function to compare the tasks in the order in which they are partitioned: by criticality level, then by utilisation at that level, both decreasing.
+    The ties are broken on the task number, so that the partition does not depend on the sort.
+*/
+int allocation_order_comparator(const void *A, const void *B)
+{
+    const allocation_order_struct *a = (const allocation_order_struct *)A;
+    const allocation_order_struct *b = (const allocation_order_struct *)B;
+
+    if (a->criticality_lvl != b->criticality_lvl)
+        return b->criticality_lvl - a->criticality_lvl;
+    if (a->util != b->util)
+        return (a->util < b->util) - (a->util > b->util);
+    return a->task_number - b->task_number;
+}
+
+/*
+    Function to find the load of a core, which is its highest utilisation over the criticality levels.
+    If the task is not NULL, the load is found as if the task were allocated to the core.
+*/
+double find_core_load(core_struct *core, task *curr_task, int total_levels)
+{
+    double load = 0.00, util;
+    int i;
+
+    for (i = 0; i < total_levels; i++)
+    {
+        util = 1.00 - core->rem_util[i];
+        if (curr_task != NULL && i <= curr_task->criticality_lvl)
+            util += curr_task->util[i];
+        load = fmax(load, util);
+    }
+    return load;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to taskset, pointer to processor}
+                processor->allocation is ALLOCATION_FFD, ALLOCATION_WFD or ALLOCATION_CA_TPA
+
+    Purpose of the function: Partitions the tasks onto the cores. The tasks are taken by decreasing criticality level, and by decreasing utilisation at their level within a level,
+                             and each task goes to a core that stays schedulable under EDF-VD with it, as found by check_task_admission from the utilisation matrix of the core.
+                             First-fit (FFD) takes the first such core, so the tasks are packed on as few cores as possible.
+                             Worst-fit (WFD) takes the one with the most utilisation left at the level of the task, so the load is spread over the cores.
+                             The criticality-aware variant (CA_TPA) takes the one whose load, the highest utilisation over the levels, grows the least, and the least loaded one among those,
+                             so that a task goes where it fills the spare utilisation of its levels and the high criticality tasks placed first are balanced at every level and not only at their own.
+                             The ties are broken on the lower core. As the admission test is O(L^2), the partitioning is O(N * C * L^2) for N tasks on C cores.
+
+    Postconditions:
+        Output: {1 if every task was allocated, 0 otherwise}
+        Result: The tasks are added to their cores with add_task_to_core.
+*/
+int partition_tasks(task_set_struct *task_set, processor_struct *processor)
+{
+    task *task_list = task_set->task_list;
+    allocation_order_struct *order;
+    task *curr_task;
+    double load, total_load, best_load = 0.00, best_total_load = 0.00;
+    int i, j, best_core, better;
+
+    order = (allocation_order_struct *)malloc(sizeof(allocation_order_struct) * max_int(task_set->total_tasks, 1));
+    for (i = 0; i < task_set->total_tasks; i++)
+    {
+        task_list[i].core = -1;
+        task_list[i].virtual_deadline = task_list[i].relative_deadline;
+        order[i].task_number = i;
+        order[i].criticality_lvl = task_list[i].criticality_lvl;
+        order[i].util = task_list[i].util[task_list[i].criticality_lvl];
+    }
+    qsort((void *)order, task_set->total_tasks, sizeof(allocation_order_struct), allocation_order_comparator);
+
+    for (i = 0; i < task_set->total_tasks; i++)
+    {
+        curr_task = &task_list[order[i].task_number];
+        best_core = -1;
+
+        for (j = 0; j < processor->total_cores; j++)
+        {
+            load = total_load = 0.00;
+            if (processor->allocation == ALLOCATION_WFD)
+            {
+                load = -processor->cores[j].rem_util[curr_task->criticality_lvl];
+            }
+            else if (processor->allocation == ALLOCATION_CA_TPA)
+            {
+                total_load = find_core_load(&processor->cores[j], curr_task, task_set->total_levels);
+                load = total_load - find_core_load(&processor->cores[j], NULL, task_set->total_levels);
+            }
+
+            //The loads are compared with a tolerance, so that the rounding errors of the sums do not break the ties.
+            better = best_core == -1 || load < best_load - ALLOCATION_LOAD_TOLERANCE ||
+                     (load < best_load + ALLOCATION_LOAD_TOLERANCE && total_load < best_total_load - ALLOCATION_LOAD_TOLERANCE);
+
+            if (better && check_task_admission(processor, curr_task, j).x > 0)
+            {
+                best_core = j;
+                best_load = load;
+                best_total_load = total_load;
+                if (processor->allocation == ALLOCATION_FFD)
+                    break;
+            }
+        }
+
+        if (best_core == -1)
+        {
+            fprintf(processor->output_file, "Task %d cannot be allocated to any core\n", order[i].task_number);
+            free(order);
+            return 0;
+        }
+
+        add_task_to_core(processor, curr_task, best_core);
+    }
+
+    free(order);
+    return 1;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to taskset, pointer to processor}
+                Every task is allocated to a core of the processor, or to core -1 if it is not allocated.
+
+    Purpose of the function: Builds the task index of each core, the numbers of its tasks sorted on their criticality level and then their number.
+                             level_index[l] is the position of the first task of level l in task_index, and level_index[total_levels] the number of tasks of the core.
+                             The index is counted and filled in one pass over the taskset each, and the passes over the tasks of a core or of its levels at the
+                             decision points then touch only its own tasks instead of scanning the taskset.
+
+    Postconditions:
+        Output: {void}
+        Result: task_index and level_index of each core are allocated and filled.
+*/
+void initialize_task_index(task_set_struct *task_set, processor_struct *processor)
+{
+    task *task_list = task_set->task_list;
+    core_struct *core;
+    int i, l, total_levels = processor->total_levels;
+
+    for (i = 0; i < processor->total_cores; i++)
+    {
+        core = &processor->cores[i];
+        free(core->task_index);
+        free(core->level_index);
+        core->level_index = (int *)calloc(total_levels + 1, sizeof(int));
+    }
+
+    //Count the tasks of each level of each core, and turn the counts into the positions of the levels.
+    for (i = 0; i < task_set->total_tasks; i++)
+    {
+        if (task_list[i].core >= 0 && task_list[i].core < processor->total_cores)
+            processor->cores[task_list[i].core].level_index[task_list[i].criticality_lvl + 1]++;
+    }
+    for (i = 0; i < processor->total_cores; i++)
+    {
+        core = &processor->cores[i];
+        for (l = 0; l < total_levels; l++)
+        {
+            core->level_index[l + 1] += core->level_index[l];
+        }
+        core->task_index = (int *)malloc(sizeof(int) * max_int(core->level_index[total_levels], 1));
+    }
+
+    //The tasks are taken in order, so each level is sorted on the task number. The positions are moved forward while filling and restored afterwards.
+    for (i = 0; i < task_set->total_tasks; i++)
+    {
+        if (task_list[i].core >= 0 && task_list[i].core < processor->total_cores)
+        {
+            core = &processor->cores[task_list[i].core];
+            core->task_index[core->level_index[task_list[i].criticality_lvl]++] = i;
+        }
+    }
+    for (i = 0; i < processor->total_cores; i++)
+    {
+        core = &processor->cores[i];
+        for (l = total_levels; l > 0; l--)
+        {
+            core->level_index[l] = core->level_index[l - 1];
+        }
+        core->level_index[0] = 0;
+    }
+}
+
+int allocate_tasks_to_cores(task_set_struct *task_set, processor_struct *processor, char *cores_file_name)
+{
+    x_factor_struct x_factor;
     int i;
 
     FILE* cores_file;
-    cores_file = fopen("../input_cores.txt", "r");
+
+    //The partitioning heuristics find the x factor and K value of each core themselves, so the cores file is not read.
+    if (processor->allocation != ALLOCATION_FILE)
+    {
+        if (!partition_tasks(task_set, processor))
+            return 0;
+        initialize_task_index(task_set, processor);
+
+        for (i = 0; i < processor->total_cores; i++)
+        {
+            x_factor = find_x_factor(processor->cores[i].utilisation, processor->total_levels);
+            processor->cores[i].x_factor = x_factor.x;
+            processor->cores[i].threshold_crit_lvl = x_factor.k;
+            if (processor->cores[i].num_tasks_allocated == 0)
+            {
+                //A core without tasks is never used.
+                processor->cores[i].x_factor = 0;
+                processor->cores[i].state = SHUTDOWN;
+            }
+            else
+            {
+                processor->cores[i].state = ACTIVE;
+                fprintf(processor->output_file, "Core: %d, x factor: %.5lf, K value: %d\n", i, processor->cores[i].x_factor, processor->cores[i].threshold_crit_lvl);
+                set_virtual_deadlines(&task_set, processor, i, processor->cores[i].x_factor, processor->cores[i].threshold_crit_lvl);
+            }
+        }
+        fprintf(processor->output_file, "\n");
+        return 1;
+    }
+
+    cores_file = fopen(cores_file_name, "r");
+    if (cores_file == NULL)
+    {
+        fprintf(processor->output_file, "ERROR: Cannot open cores file %s\n", cores_file_name);
+        return 0;
+    }
+    for (i = 0; i < task_set->total_tasks; i++)
+    {
+        if (task_set->task_list[i].core >= processor->total_cores)
+        {
+            fprintf(processor->output_file, "ERROR: Task %d is allocated to core %d, but the processor has %d cores\n", i, task_set->task_list[i].core, processor->total_cores);
+            fclose(cores_file);
+            return 0;
+        }
+        if (task_set->task_list[i].core >= 0)
+            add_task_to_core(processor, &task_set->task_list[i], task_set->task_list[i].core);
+    }
+    initialize_task_index(task_set, processor);
     for (i = 0; i < processor->total_cores; i++)
     {
-        fscanf(cores_file, "%lf%d", &(processor->cores[i].x_factor), &(processor->cores[i].threshold_crit_lvl));
+        if (fscanf(cores_file, "%lf%d", &(processor->cores[i].x_factor), &(processor->cores[i].threshold_crit_lvl)) != 2)
+        {
+            processor->cores[i].x_factor = 0;
+        }
         if (processor->cores[i].x_factor == 0)
         {
             processor->cores[i].state = SHUTDOWN;
@@ -52,11 +350,43 @@ int allocate_tasks_to_cores(task_set_struct *task_set, processor_struct *process
         else
         {
             processor->cores[i].state = ACTIVE;
-            fprintf(output_file, "Core: %d, x factor: %.5lf, K value: %d\n", i, processor->cores[i].x_factor, processor->cores[i].threshold_crit_lvl);
-            set_virtual_deadlines(&task_set, i, processor->cores[i].x_factor, processor->cores[i].threshold_crit_lvl);
+            fprintf(processor->output_file, "Core: %d, x factor: %.5lf, K value: %d\n", i, processor->cores[i].x_factor, processor->cores[i].threshold_crit_lvl);
+            set_virtual_deadlines(&task_set, processor, i, processor->cores[i].x_factor, processor->cores[i].threshold_crit_lvl);
         }
     }
-    fprintf(output_file, "\n");
+    fprintf(processor->output_file, "\n");
     fclose(cores_file);
     return 1;
-}
\ No newline at end of file
+}
+
+void free_processor(processor_struct *processor)
+{
+    int i;
+
+    //All the jobs in the ready and discarded queues were allocated from the job pools, so freeing the pools frees them.
+    for (i = 0; i < processor->total_cores; i++)
+    {
+        free(processor->cores[i].ready_queue);
+        free(processor->cores[i].local_discarded_queue);
+        free(processor->cores[i].rem_util);
+        free(processor->cores[i].utilisation);
+        free(processor->cores[i].released_tasks);
+        free(processor->cores[i].task_index);
+        free(processor->cores[i].level_index);
+        free_event_heap(processor->cores[i].arrival_calendar, 0);
+        free_job_pool(processor->cores[i].job_pool);
+        free_trace(processor->cores[i].trace);
+        free(processor->cores[i].slack_cache->jobs);
+        free(processor->cores[i].slack_cache->entries);
+        free(processor->cores[i].slack_cache->prefix_demand);
+        free(processor->cores[i].slack_cache->density);
+        free(processor->cores[i].slack_cache->suffix_density);
+        free(processor->cores[i].slack_cache);
+    }
+    free(processor->discarded_pool);
+    pthread_mutex_destroy(&processor->discarded_lock);
+    free(processor->arrival_position);
+    free_event_heap(processor->event_calendar, 1);
+    free(processor->cores);
+    free(processor);
+}
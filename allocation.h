@@ -3,8 +3,13 @@
 
 #include "structs.h"
 
-processor_struct *initialize_processor();
-int allocate_tasks_to_cores(task_set_struct *task_set, processor_struct *processor);
+processor_struct *initialize_processor(int total_cores, int total_levels);
+int find_total_cores(char *cores_file);
+void set_processor_options(processor_struct *processor, options_struct *options);
+int partition_tasks(task_set_struct *task_set, processor_struct *processor);
+void initialize_task_index(task_set_struct *task_set, processor_struct *processor);
+int allocate_tasks_to_cores(task_set_struct *task_set, processor_struct *processor, char *cores_file);
+void free_processor(processor_struct *processor);
 
 
 #endif
\ No newline at end of file
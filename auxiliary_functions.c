@@ -1,5 +1,8 @@
 #include "functions.h"
 
+//The frequency levels of the cores. They are the same for every simulation.
+double frequency[FREQUENCY_LEVELS] = {0.5, 0.6, 0.75, 0.9, 1.00};
+
 int randnum()
 {
     int num = 4;
@@ -9,20 +12,47 @@ int randnum()
     return val;
 }
 
-/*Function to calculate gcd of two numbers*/
-double gcd(double a, double b)
+/*
+    Function to calculate the gcd of two non-negative numbers of ticks.
+    It uses the binary gcd, so the cost is logarithmic in the numbers instead of linear in their quotient.
+*/
+tick_t gcd(tick_t a, tick_t b)
 {
-    if (a == 0)
-        return b;
-    if (b == 0)
-        return a;
+    int shift;
+    uint64_t u = (uint64_t)a, v = (uint64_t)b, t;
+
+    if (u == 0)
+        return (tick_t)v;
+    if (v == 0)
+        return (tick_t)u;
+
+    shift = __builtin_ctzll(u | v);
+    u >>= __builtin_ctzll(u);
+    do
+    {
+        v >>= __builtin_ctzll(v);
+        if (u > v)
+        {
+            t = u;
+            u = v;
+            v = t;
+        }
+        v -= u;
+    } while (v != 0);
+
+    return (tick_t)(u << shift);
+}
 
-    if (a == b)
-        return a;
+/*
+    Function to calculate the lcm of two positive numbers of ticks. Returns -1 if the lcm does not fit in a tick_t.
+*/
+tick_t lcm(tick_t a, tick_t b)
+{
+    tick_t result;
 
-    if (a > b)
-        return gcd(a - b, b);
-    return gcd(a, b - a);
+    if (__builtin_mul_overflow(a / gcd(a, b), b, &result))
+        return -1;
+    return result;
 }
 
 /*Function to find min of two numbers*/
@@ -47,19 +77,40 @@ int min_int(int a, int b)
     return (a < b) ? a : b;
 }
 
-/*Custom comparator for sorting the task list*/
-int period_comparator(const void *p, const void *q)
+tick_t max_tick(tick_t a, tick_t b)
 {
-    double l = ((task *)p)->period;
-    double r = ((task *)q)->period;
+    return (a > b) ? a : b;
+}
 
-    return (l - r);
+tick_t min_tick(tick_t a, tick_t b)
+{
+    return (a < b) ? a : b;
+}
+
+/*Custom comparator for sorting the task list on the periods. The tasks of equal periods keep their order.*/
+int task_order_comparator(const void *p, const void *q)
+{
+    const task_order_struct *l = (const task_order_struct *)p;
+    const task_order_struct *r = (const task_order_struct *)q;
+
+    if (l->period != r->period)
+        return (l->period > r->period) - (l->period < r->period);
+    return (l->task_number > r->task_number) - (l->task_number < r->task_number);
+}
+
+/*Comparator for sorting an array of integers in increasing order*/
+int int_comparator(const void *p, const void *q)
+{
+    int l = *(const int *)p;
+    int r = *(const int *)q;
+
+    return (l > r) - (l < r);
 }
 
 /*
     Function to print the taskset.
 */
-void print_task_list(task_set_struct *task_set)
+void print_task_list(FILE *output_file, task_set_struct *task_set)
 {
     int i, j, total_tasks;
     task *task_list;
@@ -74,16 +125,16 @@ void print_task_list(task_set_struct *task_set)
                 i,
                 task_list[i].core,
                 task_list[i].criticality_lvl,
-                task_list[i].phase,
-                task_list[i].relative_deadline,
-                task_list[i].virtual_deadline);
+                TICKS_TO_UNITS(task_set->phase_table[i]),
+                TICKS_TO_UNITS(task_list[i].relative_deadline),
+                TICKS_TO_UNITS(task_list[i].virtual_deadline));
         fprintf(output_file, "WCET: ");
-        for (j = 0; j < MAX_CRITICALITY_LEVELS; j++)
+        for (j = 0; j < task_set->total_levels; j++)
         {
-            fprintf(output_file, "%.2lf ", task_list[i].WCET[j]);
+            fprintf(output_file, "%.2lf ", TICKS_TO_UNITS(task_list[i].WCET[j]));
         }
         fprintf(output_file, " | Util: ");
-        for (j = 0; j < MAX_CRITICALITY_LEVELS; j++)
+        for (j = 0; j < task_set->total_levels; j++)
         {
             fprintf(output_file, "%.3f ", task_list[i].util[j]);
         }
@@ -97,20 +148,20 @@ void print_task_list(task_set_struct *task_set)
 /*
     Function to print the ready queue
 */
-void print_job_list(int core_no, job *job_list_head)
+void print_job_list(FILE *output, job *job_list_head)
 {
     job *job_temp = job_list_head;
     // fprintf(output_file, "\n");
     while (job_temp != NULL)
     {
-        fprintf(output[core_no], "Job:: Task no: %d  Release time: %.2lf  Exec time: %.2lf  Rem Exec time: %.2lf  WCET_counter: %.2lf  Deadline: %.2lf\n",
+        fprintf(output, "Job:: Task no: %d  Release time: %.2lf  Exec time: %.2lf  Rem Exec time: %.2lf  WCET_counter: %.2lf  Deadline: %.2lf\n",
                 job_temp->task_number,
-                job_temp->release_time,
-                job_temp->execution_time,
-                job_temp->rem_exec_time,
-                job_temp->WCET_counter,
-                job_temp->absolute_deadline);
-        job_temp = job_temp->next;
+                TICKS_TO_UNITS(job_temp->release_time),
+                TICKS_TO_UNITS(job_temp->execution_time),
+                TICKS_TO_UNITS(job_temp->rem_exec_time),
+                TICKS_TO_UNITS(job_temp->WCET_counter),
+                TICKS_TO_UNITS(job_temp->absolute_deadline));
+        job_temp = next_job_in_queue(job_temp);
     }
 
     return;
@@ -119,15 +170,15 @@ void print_job_list(int core_no, job *job_list_head)
 /*
     Function to print the utilisation matrix. 
 */
-void print_total_utilisation(double total_utilisation[][MAX_CRITICALITY_LEVELS])
+void print_total_utilisation(FILE *output_file, double *total_utilisation, int total_levels)
 {
     int i, j;
     fprintf(output_file, "\nTotal utilisation:\n");
-    for (i = 0; i < MAX_CRITICALITY_LEVELS; i++)
+    for (i = 0; i < total_levels; i++)
     {
-        for (j = 0; j < MAX_CRITICALITY_LEVELS; j++)
+        for (j = 0; j < total_levels; j++)
         {
-            fprintf(output_file, "%lf  ", total_utilisation[i][j]);
+            fprintf(output_file, "%lf  ", total_utilisation[i * total_levels + j]);
         }
         fprintf(output_file, "\n");
     }
@@ -137,18 +188,18 @@ void print_total_utilisation(double total_utilisation[][MAX_CRITICALITY_LEVELS])
 void print_processor(processor_struct *processor)
 {
     int i;
-    fprintf(output_file, "\nProcessor statistics:\n");
-    fprintf(output_file, "Num cores: %d\n", processor->total_cores);
+    fprintf(processor->output_file, "\nProcessor statistics:\n");
+    fprintf(processor->output_file, "Num cores: %d\n", processor->total_cores);
     for (i = 0; i < processor->total_cores; i++)
     {
-        fprintf(output_file, "Core: %d, total time: %.2lf, total idle time: %.2lf, total busy time: %.2lf, state: %s\n",
+        fprintf(processor->output_file, "Core: %d, total time: %.2lf, total idle time: %.2lf, total busy time: %.2lf, state: %s\n",
                 i,
-                processor->cores[i].total_time,
-                processor->cores[i].total_idle_time,
-                processor->cores[i].total_time - processor->cores[i].total_idle_time,
+                TICKS_TO_UNITS(processor->cores[i].total_time),
+                TICKS_TO_UNITS(processor->cores[i].total_idle_time),
+                TICKS_TO_UNITS(processor->cores[i].total_time - processor->cores[i].total_idle_time),
                 (processor->cores[i].state == ACTIVE) ? "ACTIVE" : "SHUTDOWN");
     }
-    fprintf(output_file, "\n");
+    fprintf(processor->output_file, "\n");
 }
 
 /*
@@ -192,52 +243,39 @@ double find_actual_execution_time(double exec_time, int task_crit_lvl, int core_
     return exec_time;
 }
 
-void set_virtual_deadlines(task_set_struct **task_set, int core_no, double x, int k)
+void set_virtual_deadlines(task_set_struct **task_set, processor_struct *processor, int core_no, double x, int k)
 {
-    int num_task;
+    core_struct *core = &processor->cores[core_no];
+    int i, num_task;
 
-    for (num_task = 0; num_task < (*task_set)->total_tasks; num_task++)
+    for (i = 0; i < core->level_index[processor->total_levels]; i++)
     {
-        if ((*task_set)->task_list[num_task].core == core_no)
+        num_task = core->task_index[i];
+        if ((*task_set)->task_list[num_task].criticality_lvl <= k)
         {
-            if ((*task_set)->task_list[num_task].criticality_lvl <= k)
-            {
-                (*task_set)->task_list[num_task].virtual_deadline = (*task_set)->task_list[num_task].relative_deadline;
-            }
-            else
-            {
-                (*task_set)->task_list[num_task].virtual_deadline = x * (*task_set)->task_list[num_task].relative_deadline;
-            }
+            (*task_set)->task_list[num_task].virtual_deadline = (*task_set)->task_list[num_task].relative_deadline;
+        }
+        else
+        {
+            (*task_set)->task_list[num_task].virtual_deadline = (tick_t)(x * (*task_set)->task_list[num_task].relative_deadline);
         }
     }
     return;
 }
 
-void reset_virtual_deadlines(task_set_struct **task_set, int num_core, int k)
+void reset_virtual_deadlines(task_set_struct **task_set, processor_struct *processor, int num_core, int k)
 {
+    core_struct *core = &processor->cores[num_core];
     int i;
-    for (i = 0; i < (*task_set)->total_tasks; i++)
+
+    //Only the tasks above level k have a shortened virtual deadline.
+    for (i = core->level_index[min_int(k + 1, processor->total_levels)]; i < core->level_index[processor->total_levels]; i++)
     {
-        if ((*task_set)->task_list[i].criticality_lvl > k && (*task_set)->task_list[i].core == num_core)
-            (*task_set)->task_list[i].virtual_deadline = (*task_set)->task_list[i].relative_deadline;
+        (*task_set)->task_list[core->task_index[i]].virtual_deadline = (*task_set)->task_list[core->task_index[i]].relative_deadline;
     }
     return;
 }
 
-void set_execution_times(job* curr_job, double frequency)
-{
-    curr_job->execution_time /= frequency;
-    curr_job->rem_exec_time /= frequency;
-    curr_job->WCET_counter /= frequency;
-}
-
-void reset_execution_times(job* curr_job, double frequency)
-{
-    curr_job->execution_time *= frequency;
-    curr_job->rem_exec_time *= frequency;
-    curr_job->WCET_counter *= frequency;
-}
-
 int check_all_cores(processor_struct *processor)
 {
     int flag = 1;
@@ -254,7 +292,7 @@ int check_all_cores(processor_struct *processor)
 
 int find_max_level(processor_struct *processor, task_set_struct *task_set)
 {
-    int max_crit_level = MAX_CRITICALITY_LEVELS - 1;
+    int max_crit_level = task_set->total_levels - 1;
 
     for (int i = 0; i < processor->total_cores; i++)
     {
@@ -263,26 +301,76 @@ int find_max_level(processor_struct *processor, task_set_struct *task_set)
         while (temp)
         {
             max_crit_level = (max_crit_level > task_set->task_list[temp->task_number].criticality_lvl) ? max_crit_level : task_set->task_list[temp->task_number].criticality_lvl;
-            temp = temp->next;
+            temp = next_job_in_queue(temp);
         }
     }
     return max_crit_level;
 }
 
-stats_struct* initialize_stats_struct()
+stats_struct* initialize_stats_struct(int total_cores)
 {
-    stats = malloc(sizeof(stats_struct));
-    stats->total_active_energy = calloc(NUM_CORES, sizeof(double));
-    stats->total_idle_energy = calloc(NUM_CORES, sizeof(double));
-    stats->total_shutdown_time = calloc(NUM_CORES, sizeof(double));
-    stats->total_arrival_points = calloc(NUM_CORES, sizeof(int));
-    stats->total_completion_points = calloc(NUM_CORES, sizeof(int));
-    stats->total_criticality_change_points = calloc(NUM_CORES, sizeof(int));
-    stats->total_wakeup_points = calloc(NUM_CORES, sizeof(int));
-    stats->total_context_switches = calloc(NUM_CORES, sizeof(int));
-    stats->total_discarded_jobs = calloc(NUM_CORES, sizeof(int));
-    stats->total_discarded_jobs_executed = calloc(NUM_CORES, sizeof(double));
-    stats->total_discarded_jobs_available = calloc(NUM_CORES, sizeof(double));
+    stats_struct *stats = malloc(sizeof(stats_struct));
+    stats->total_active_energy = calloc(total_cores, sizeof(double));
+    stats->total_idle_energy = calloc(total_cores, sizeof(double));
+    stats->total_shutdown_time = calloc(total_cores, sizeof(double));
+    stats->total_arrival_points = calloc(total_cores, sizeof(int));
+    stats->total_completion_points = calloc(total_cores, sizeof(int));
+    stats->total_criticality_change_points = calloc(total_cores, sizeof(int));
+    stats->total_wakeup_points = calloc(total_cores, sizeof(int));
+    stats->total_context_switches = calloc(total_cores, sizeof(int));
+    stats->total_discarded_jobs = calloc(total_cores, sizeof(int));
+    stats->total_deadline_misses = calloc(total_cores, sizeof(int));
+    stats->total_frequency_switches = calloc(total_cores, sizeof(int));
+    stats->total_discarded_jobs_executed = calloc(total_cores, sizeof(double));
+    stats->total_discarded_jobs_available = calloc(total_cores, sizeof(double));
+    stats->total_preemptions = calloc(total_cores, sizeof(int));
+    stats->total_completed_jobs = calloc(total_cores, sizeof(int));
+    stats->total_migrations = calloc(total_cores, sizeof(int));
+    stats->response_time = initialize_histograms(total_cores);
+    stats->lateness = initialize_histograms(total_cores);
+    stats->preemptions = initialize_histograms(total_cores);
+    stats->queue_depth = initialize_histograms(total_cores);
+    stats->decision_latency = initialize_histograms(total_cores);
+    stats->total_cores = total_cores;
+    stats->record_latency = 0;
+    stats->record_tasks = 0;
+    stats->total_tasks = 0;
+    stats->task_core = NULL;
+    stats->task_criticality_lvl = NULL;
+    stats->task_response_time = NULL;
+    stats->task_slack = NULL;
+    stats->task_tardiness = NULL;
 
     return stats;
+}
+
+void free_stats_struct(stats_struct *stats)
+{
+    free(stats->total_active_energy);
+    free(stats->total_idle_energy);
+    free(stats->total_shutdown_time);
+    free(stats->total_arrival_points);
+    free(stats->total_completion_points);
+    free(stats->total_criticality_change_points);
+    free(stats->total_wakeup_points);
+    free(stats->total_context_switches);
+    free(stats->total_discarded_jobs);
+    free(stats->total_deadline_misses);
+    free(stats->total_frequency_switches);
+    free(stats->total_discarded_jobs_executed);
+    free(stats->total_discarded_jobs_available);
+    free(stats->total_preemptions);
+    free(stats->total_completed_jobs);
+    free(stats->total_migrations);
+    free(stats->response_time);
+    free(stats->lateness);
+    free(stats->preemptions);
+    free(stats->queue_depth);
+    free(stats->decision_latency);
+    free(stats->task_core);
+    free(stats->task_criticality_lvl);
+    free(stats->task_response_time);
+    free(stats->task_slack);
+    free(stats->task_tardiness);
+    free(stats);
 }
\ No newline at end of file
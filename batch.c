@@ -0,0 +1,369 @@
+#include "functions.h"
+
+#include <pthread.h>
+
+#define MAX_BATCH_LINE 4096
+
+/*
+    ADT for a simulation of the batch.
+        input_files: The input files of the taskset.
+        line: The line of the batch file, which owns the file names.
+        schedulable: 1 if the taskset was allocated and scheduled, 0 if not, -1 if it could not be read.
+        active_energy, idle_energy: The active and idle energy of the processor, summed over the cores.
+        shutdown_time: The time the cores spent shut down, summed over the cores.
+        discarded_jobs_available, discarded_jobs_executed: The time available to the discarded jobs and the time they executed, summed over the cores.
+        arrival_points, completion_points, criticality_change_points: The decision points of each kind, summed over the cores.
+        context_switches, frequency_switches: The context and frequency switches, summed over the cores.
+        discarded_jobs, deadline_misses: The discarded jobs and the deadline misses, summed over the cores.
+        core_stats: The statistics of each core, kept for the statistics file of the batch. NULL if there is none or the taskset could not be simulated.
+        wall_time: The time taken by the simulation in seconds.
+*/
+typedef struct batch_simulation_struct
+{
+    input_files_struct input_files;
+    char *line;
+    int schedulable;
+    double active_energy;
+    double idle_energy;
+    double shutdown_time;
+    double discarded_jobs_available;
+    double discarded_jobs_executed;
+    int arrival_points;
+    int completion_points;
+    int criticality_change_points;
+    int context_switches;
+    int frequency_switches;
+    int discarded_jobs;
+    int deadline_misses;
+    stats_struct *core_stats;
+    double wall_time;
+} batch_simulation_struct;
+
+/*
+    ADT for the work shared by the threads of the batch.
+*/
+typedef struct batch_struct
+{
+    batch_simulation_struct *simulations;
+    int num_simulations;
+    int next_simulation;
+    pthread_mutex_t lock;
+    options_struct options;
+    int keep_stats;
+} batch_struct;
+
+double elapsed_seconds(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the batch, pointer to the simulation}
+
+    Purpose of the function: Runs one simulation of the batch. The taskset, processor, statistics and output sinks are all private to the simulation, so simulations can run on different threads.
+                             The schedules of the cores are not kept in batch mode, so their traces are disabled and the output file is discarded.
+
+    Postconditions:
+        Output: {void}
+        Result: The statistics of the simulation are stored in the simulation.
+*/
+void run_batch_simulation(batch_struct *batch, batch_simulation_struct *simulation)
+{
+    struct timespec start, end;
+    task_set_struct *task_set;
+    processor_struct *processor;
+    FILE *null_sink;
+    int total_cores, i;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    simulation->schedulable = -1;
+    if (batch->options.allocation != ALLOCATION_FILE)
+        simulation->input_files.allocation_file = NULL;
+    task_set = get_taskset(&simulation->input_files);
+    if (task_set == NULL)
+        return;
+    if (batch->options.exec_time_type != EXEC_TIME_TRACE)
+        set_exec_time_source(task_set, batch->options.exec_time_type, batch->options.seed, batch->options.fraction, batch->options.overrun_probability);
+
+    //Unless the number of cores is given for the whole batch, each taskset gets one core for each entry of its cores file.
+    total_cores = (batch->options.total_cores > 0) ? batch->options.total_cores : find_total_cores(simulation->input_files.cores_file);
+    if (total_cores == 0)
+    {
+        printf("ERROR: Cannot read the cores file %s\n", simulation->input_files.cores_file);
+        free_taskset(task_set);
+        return;
+    }
+
+    processor = initialize_processor(total_cores, task_set->total_levels);
+    processor->stats = initialize_stats_struct(processor->total_cores);
+    processor->stats->record_latency = batch->keep_stats;
+    processor->stats->record_tasks = batch->keep_stats;
+    set_processor_options(processor, &batch->options);
+    null_sink = fopen("/dev/null", "w");
+    processor->output_file = null_sink;
+    for (i = 0; i < processor->total_cores; i++)
+    {
+        processor->cores[i].trace = initialize_trace(NULL, TRACE_NONE, TRACE_TEXT);
+    }
+
+    simulation->schedulable = runtime_scheduler(task_set, processor, simulation->input_files.cores_file);
+
+    for (i = 0; i < processor->total_cores; i++)
+    {
+        simulation->active_energy += processor->stats->total_active_energy[i];
+        simulation->idle_energy += processor->stats->total_idle_energy[i];
+        simulation->shutdown_time += processor->stats->total_shutdown_time[i];
+        simulation->discarded_jobs_available += processor->stats->total_discarded_jobs_available[i];
+        simulation->discarded_jobs_executed += processor->stats->total_discarded_jobs_executed[i];
+        simulation->arrival_points += processor->stats->total_arrival_points[i];
+        simulation->completion_points += processor->stats->total_completion_points[i];
+        simulation->criticality_change_points += processor->stats->total_criticality_change_points[i];
+        simulation->context_switches += processor->stats->total_context_switches[i];
+        simulation->frequency_switches += processor->stats->total_frequency_switches[i];
+        simulation->discarded_jobs += processor->stats->total_discarded_jobs[i];
+        simulation->deadline_misses += processor->stats->total_deadline_misses[i];
+    }
+
+    fclose(null_sink);
+    if (batch->keep_stats)
+        simulation->core_stats = processor->stats;
+    else
+        free_stats_struct(processor->stats);
+    free_processor(processor);
+    free_taskset(task_set);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    simulation->wall_time = elapsed_seconds(&start, &end);
+}
+
+/*
+    Function run by each thread of the pool. The threads take the next simulation of the batch until none is left.
+*/
+void *batch_worker(void *argument)
+{
+    batch_struct *batch = (batch_struct *)argument;
+    int index;
+
+    while (1)
+    {
+        pthread_mutex_lock(&batch->lock);
+        index = batch->next_simulation++;
+        pthread_mutex_unlock(&batch->lock);
+
+        if (index >= batch->num_simulations)
+            break;
+
+        run_batch_simulation(batch, &batch->simulations[index]);
+    }
+
+    return NULL;
+}
+
+/*
+    Function to parse a line of the batch file. A line names either the four text input files or a binary taskset and a cores file.
+    Returns 0 for blank lines, comments (#) and malformed lines.
+*/
+int parse_batch_line(char *line, batch_simulation_struct *simulation)
+{
+    char *fields[4];
+    char *save = NULL;
+    int num_fields = 0;
+    char *token = strtok_r(line, " \t\r\n", &save);
+
+    while (token != NULL && num_fields < 4)
+    {
+        fields[num_fields++] = token;
+        token = strtok_r(NULL, " \t\r\n", &save);
+    }
+
+    if (num_fields == 0 || fields[0][0] == '#')
+        return 0;
+
+    memset(simulation, 0, sizeof(batch_simulation_struct));
+    if (num_fields == 4)
+    {
+        simulation->input_files.taskset_file = fields[0];
+        simulation->input_files.exec_times_file = (strcmp(fields[1], "-") == 0) ? NULL : fields[1];
+        simulation->input_files.allocation_file = fields[2];
+        simulation->input_files.cores_file = fields[3];
+        simulation->input_files.binary_file = NULL;
+    }
+    else if (num_fields == 2)
+    {
+        simulation->input_files.binary_file = fields[0];
+        simulation->input_files.cores_file = fields[1];
+    }
+    else
+    {
+        printf("ERROR: Malformed batch line starting with %s\n", fields[0]);
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+    Function to write the statistics of the simulated tasksets of the batch to the statistics file. The run number of a taskset is its row of the summary.
+*/
+void write_batch_stats(batch_struct *batch, char *stats_file)
+{
+    int format = find_stats_format(stats_file);
+    FILE *output = fopen(stats_file, "w");
+    int i, first = 1;
+
+    if (output == NULL)
+    {
+        printf("ERROR: Cannot open statistics file %s\n", stats_file);
+        return;
+    }
+
+    write_stats_header(output, format);
+    for (i = 0; i < batch->num_simulations; i++)
+    {
+        batch_simulation_struct *simulation = &batch->simulations[i];
+        char *name = (simulation->input_files.binary_file != NULL) ? simulation->input_files.binary_file : simulation->input_files.taskset_file;
+
+        if (simulation->core_stats == NULL)
+            continue;
+        write_stats_run(output, format, i, name, simulation->core_stats, first);
+        first = 0;
+    }
+    write_stats_footer(output, format);
+    fclose(output);
+}
+
+/*
+    Preconditions:
+        Input: {name of the batch file, name of the summary file, name of the statistics file or NULL, number of threads, pointer to the options of the simulations}
+
+    Purpose of the function: Simulates every taskset listed in the batch file on a pool of threads and writes one line per taskset, followed by the totals, to the summary file.
+                             If a statistics file is given, the statistics of each core of each taskset are also written to it, one run per line of the batch file.
+                             The tasksets are independent, so the results do not depend on the number of threads.
+
+    Postconditions:
+        Output: {0 on success, 1 if the batch or summary file cannot be opened}
+*/
+int run_batch(char *batch_file, char *summary_file, char *stats_file, int num_threads, options_struct *options)
+{
+    struct timespec start, end;
+    batch_struct batch;
+    batch_simulation_struct total;
+    pthread_t *threads;
+    char line[MAX_BATCH_LINE];
+    int max_simulations = 64;
+    int num_schedulable = 0;
+    FILE *fd, *summary;
+    int i;
+
+    fd = fopen(batch_file, "r");
+    if (fd == NULL)
+    {
+        printf("ERROR: Cannot open batch file %s\n", batch_file);
+        return 1;
+    }
+
+    //The summary file is opened before the simulations, so that nothing is simulated or allocated if it cannot be written.
+    summary = fopen(summary_file, "w");
+    if (summary == NULL)
+    {
+        printf("ERROR: Cannot open summary file %s\n", summary_file);
+        fclose(fd);
+        return 1;
+    }
+
+    memset(&batch, 0, sizeof(batch));
+    batch.simulations = (batch_simulation_struct *)malloc(sizeof(batch_simulation_struct) * max_simulations);
+    batch.options = *options;
+    batch.keep_stats = (stats_file != NULL);
+    pthread_mutex_init(&batch.lock, NULL);
+
+    while (fgets(line, MAX_BATCH_LINE, fd) != NULL)
+    {
+        char *owned_line = strdup(line);
+
+        if (batch.num_simulations == max_simulations)
+        {
+            max_simulations *= 2;
+            batch.simulations = (batch_simulation_struct *)realloc(batch.simulations, sizeof(batch_simulation_struct) * max_simulations);
+        }
+        if (parse_batch_line(owned_line, &batch.simulations[batch.num_simulations]))
+            batch.simulations[batch.num_simulations++].line = owned_line;
+        else
+            free(owned_line);
+    }
+    fclose(fd);
+
+    printf("Simulating %d tasksets on %d threads\n", batch.num_simulations, num_threads);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    threads = (pthread_t *)malloc(sizeof(pthread_t) * num_threads);
+    for (i = 0; i < num_threads; i++)
+    {
+        pthread_create(&threads[i], NULL, batch_worker, &batch);
+    }
+    for (i = 0; i < num_threads; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    memset(&total, 0, sizeof(total));
+    fprintf(summary, "%-6s %-11s %-12s %-12s %-12s %-9s %-9s %-9s %-9s %-9s %-9s %-12s %-12s %-9s %s\n",
+            "run", "schedulable", "active", "idle", "shutdown", "arrivals", "complete", "critchg", "switches", "freqchg", "discard", "disc_avail", "disc_exec", "misses", "taskset");
+    for (i = 0; i < batch.num_simulations; i++)
+    {
+        batch_simulation_struct *simulation = &batch.simulations[i];
+        char *name = (simulation->input_files.binary_file != NULL) ? simulation->input_files.binary_file : simulation->input_files.taskset_file;
+
+        fprintf(summary, "%-6d %-11d %-12.2lf %-12.2lf %-12.2lf %-9d %-9d %-9d %-9d %-9d %-9d %-12.2lf %-12.2lf %-9d %s\n",
+                i, simulation->schedulable,
+                simulation->active_energy, simulation->idle_energy, simulation->shutdown_time,
+                simulation->arrival_points, simulation->completion_points, simulation->criticality_change_points,
+                simulation->context_switches, simulation->frequency_switches, simulation->discarded_jobs,
+                simulation->discarded_jobs_available, simulation->discarded_jobs_executed,
+                simulation->deadline_misses, name);
+
+        num_schedulable += (simulation->schedulable == 1);
+        total.active_energy += simulation->active_energy;
+        total.idle_energy += simulation->idle_energy;
+        total.shutdown_time += simulation->shutdown_time;
+        total.arrival_points += simulation->arrival_points;
+        total.completion_points += simulation->completion_points;
+        total.criticality_change_points += simulation->criticality_change_points;
+        total.context_switches += simulation->context_switches;
+        total.frequency_switches += simulation->frequency_switches;
+        total.discarded_jobs += simulation->discarded_jobs;
+        total.discarded_jobs_available += simulation->discarded_jobs_available;
+        total.discarded_jobs_executed += simulation->discarded_jobs_executed;
+        total.deadline_misses += simulation->deadline_misses;
+        total.wall_time += simulation->wall_time;
+    }
+    fprintf(summary, "%-6s %-11d %-12.2lf %-12.2lf %-12.2lf %-9d %-9d %-9d %-9d %-9d %-9d %-12.2lf %-12.2lf %-9d %d tasksets\n",
+            "total", num_schedulable,
+            total.active_energy, total.idle_energy, total.shutdown_time,
+            total.arrival_points, total.completion_points, total.criticality_change_points,
+            total.context_switches, total.frequency_switches, total.discarded_jobs,
+            total.discarded_jobs_available, total.discarded_jobs_executed,
+            total.deadline_misses, batch.num_simulations);
+    fclose(summary);
+
+    printf("%d of %d tasksets schedulable. Simulation time %.3lf s, wall clock time %.3lf s\n", num_schedulable, batch.num_simulations, total.wall_time, elapsed_seconds(&start, &end));
+
+    if (stats_file != NULL)
+        write_batch_stats(&batch, stats_file);
+
+    for (i = 0; i < batch.num_simulations; i++)
+    {
+        if (batch.simulations[i].core_stats != NULL)
+            free_stats_struct(batch.simulations[i].core_stats);
+        free(batch.simulations[i].line);
+    }
+    free(batch.simulations);
+    free(threads);
+    pthread_mutex_destroy(&batch.lock);
+
+    return 0;
+}
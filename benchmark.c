@@ -0,0 +1,507 @@
+#include "functions.h"
+
+#define MAX_BENCHMARK_CORES 32
+//The number of passes of the kernel benchmark over its tasksets in each repetition.
+#define KERNEL_BENCHMARK_PASSES 2000
+
+/*
+    ADT for the results of one point of the sweep, summed over its tasksets.
+        accepted: The number of tasksets partitioned onto the cores. A taskset the generator cannot draw counts as not accepted.
+        decisions: The number of decision points of the simulations (arrivals, completions, criticality changes and wakeups).
+        allocation_time: The time taken by the partitioning of all the tasksets, in seconds.
+        simulation_time: The time taken by the simulations of the accepted tasksets, in seconds. It is the fastest of the repetitions.
+*/
+typedef struct benchmark_point_struct
+{
+    int total_cores;
+    double util;
+    int accepted;
+    int deadline_misses;
+    int discarded_jobs;
+    int migrations;
+    double discarded_jobs_available;
+    double discarded_jobs_executed;
+    long decisions;
+    double allocation_time;
+    double simulation_time;
+} benchmark_point_struct;
+
+double benchmark_seconds(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+void print_benchmark_usage(char *program)
+{
+    printf("Usage: %s [-n tasks] [-L levels] [-S sets] [-u first:last:step] [-m cores,...] [-s seed] [-r repetitions] [-A] [-K]\n", program);
+    printf("          [-P ffd|wfd|ca-tpa] [-Q partitioned|semi] [-W global|core|cluster_size] [-g none|cc] [-z threshold] [-p overrun_probability] [-f fraction] [-R log|harmonic[:min:max[:granularity]]] [-J threads] [-X]\n");
+    printf("  Sweeps the normalised utilisation (-u, default 0.1:1:0.1) and the number of cores (-m, default 1,2,4). At each point -S (default 100) tasksets\n");
+    printf("  of -n tasks (default 20) and -L levels (default 2) are generated with a target utilisation of util * cores at every level, partitioned (-P, default wfd)\n");
+    printf("  and, unless -A is given, the accepted ones are simulated -r times (default 3) with the execution times sampled from -p (default 0.1) and -f (default 0.5).\n");
+    printf("  -K keeps simulating a taskset after a deadline miss, so that the misses of overloaded tasksets are all counted.\n");
+    printf("  -J simulates the cores of each taskset on that many threads.\n");
+    printf("  -X times the kernels of the schedulability analysis of each instruction set instead, on -S tasksets at the first utilisation of -u on the first number of cores of -m.\n");
+    printf("  The tasksets depend only on the seed (-s), so the numbers of a sweep are reproducible and its timings are the fastest of the repetitions.\n");
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the generator, pointer to the options, pointer to the point, whether the taskset is simulated, whether the statistics are recorded}
+
+    Purpose of the function: Generates the taskset of the generator, partitions it onto the cores of the point and, if it is accepted and simulate is set, simulates it.
+                             The schedules are not written, as in batch mode. The partitioning and simulation times are added to the point,
+                             and the statistics only if record is set, so that the repetitions of a point count its tasksets once.
+
+    Postconditions:
+        Output: {The time taken by the simulation, in seconds}
+*/
+double run_benchmark_taskset(generator_struct *generator, options_struct *options, benchmark_point_struct *point, int simulate, int record)
+{
+    struct timespec start, end;
+    task_set_struct *task_set;
+    processor_struct *processor;
+    FILE *null_sink;
+    double simulation_time = 0.00;
+    int accepted, i;
+
+    task_set = generate_taskset(generator);
+    if (task_set == NULL)
+        return 0.00;
+    set_exec_time_source(task_set, options->exec_time_type, options->seed, options->fraction, options->overrun_probability);
+
+    processor = initialize_processor(point->total_cores, task_set->total_levels);
+    processor->stats = initialize_stats_struct(processor->total_cores);
+    set_processor_options(processor, options);
+    null_sink = fopen("/dev/null", "w");
+    processor->output_file = null_sink;
+    for (i = 0; i < processor->total_cores; i++)
+    {
+        processor->cores[i].trace = initialize_trace(NULL, TRACE_NONE, TRACE_TEXT);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    accepted = allocate_tasks_to_cores(task_set, processor, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (record)
+    {
+        point->accepted += accepted;
+        point->allocation_time += benchmark_seconds(&start, &end);
+    }
+
+    if (accepted && simulate)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        schedule_taskset(task_set, processor);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        simulation_time = benchmark_seconds(&start, &end);
+
+        for (i = 0; i < processor->total_cores && record; i++)
+        {
+            point->deadline_misses += processor->stats->total_deadline_misses[i];
+            point->discarded_jobs += processor->stats->total_discarded_jobs[i];
+            point->migrations += processor->stats->total_migrations[i];
+            point->discarded_jobs_available += processor->stats->total_discarded_jobs_available[i];
+            point->discarded_jobs_executed += processor->stats->total_discarded_jobs_executed[i];
+            point->decisions += processor->stats->total_arrival_points[i] + processor->stats->total_completion_points[i] +
+                                processor->stats->total_criticality_change_points[i] + processor->stats->total_wakeup_points[i];
+        }
+    }
+
+    fclose(null_sink);
+    free_stats_struct(processor->stats);
+    free_processor(processor);
+    free_taskset(task_set);
+
+    return simulation_time;
+}
+
+/*
+    Function to find the utilisation matrix of a core by scanning the taskset and testing the core and level of each task, as before the task index.
+    It is the baseline of the kernel benchmark.
+*/
+void scan_total_utilisation(task_set_struct *task_set, double *total_utilisation, int core_no)
+{
+    int total_levels = task_set->total_levels;
+    int i, k;
+
+    for (k = 0; k < total_levels * total_levels; k++)
+    {
+        total_utilisation[k] = 0;
+    }
+    for (i = 0; i < task_set->total_tasks; i++)
+    {
+        if (task_set->task_list[i].core != core_no)
+            continue;
+        for (k = 0; k < total_levels; k++)
+        {
+            total_utilisation[task_set->task_list[i].criticality_lvl * total_levels + k] += task_set->task_list[i].util[k];
+        }
+    }
+}
+
+/*
+    Preconditions:
+        Input: {the partitioned tasksets and their processors, the jobs of each taskset and the time of its densities, the number of tasksets, the number of repetitions}
+                num_sets > 0, and the tasksets have the same number of levels.
+
+    Purpose of the function: Times the kernels of each instruction set the processor supports. A pass finds the utilisation matrix of every core of every taskset
+                             and the demand densities of the jobs of every taskset. The scan of the taskset is the baseline of the matrices and the scalar kernels
+                             the baseline of the densities. The results of each instruction set are checked against the baselines to the bit.
+
+    Postconditions:
+        Output: {0 if every instruction set gave the results of the baselines, 1 otherwise}
+*/
+int time_kernels(task_set_struct **task_sets, processor_struct **processors, double **jobs, double *times, int num_sets, int repetitions)
+{
+    int total_cores = processors[0]->total_cores, total_levels = task_sets[0]->total_levels;
+    int matrix_size = total_cores * total_levels * total_levels, max_tasks = 1;
+    double **matrices = (double **)malloc(sizeof(double *) * num_sets);
+    double **densities = (double **)malloc(sizeof(double *) * num_sets);
+    double *matrix = (double *)malloc(sizeof(double) * matrix_size), *density;
+    double matrix_time[KERNEL_SETS + 1], density_time[KERNEL_SETS + 1], time;
+    struct timespec start, end;
+    kernel_struct *kernels;
+    int set, core_no, pass, repetition, instruction_set, same, failed = 0;
+
+    for (set = 0; set < num_sets; set++)
+    {
+        max_tasks = max_int(max_tasks, task_sets[set]->total_tasks);
+        matrices[set] = (double *)malloc(sizeof(double) * matrix_size);
+        densities[set] = (double *)malloc(sizeof(double) * max_int(task_sets[set]->total_tasks, 1));
+        for (core_no = 0; core_no < total_cores; core_no++)
+        {
+            scan_total_utilisation(task_sets[set], matrices[set] + core_no * total_levels * total_levels, core_no);
+        }
+        find_demand_densities_scalar(densities[set], jobs[set], task_sets[set]->total_tasks, times[set]);
+    }
+    density = (double *)malloc(sizeof(double) * max_tasks);
+
+    printf("%-8s %-11s %-8s %-11s %-8s %s\n", "kernels", "matrix_ns", "speedup", "density_ns", "speedup", "results");
+
+    //Entry 0 of the times is the scan of the taskset, and entry i + 1 the kernels of instruction set i.
+    for (instruction_set = -1; instruction_set < KERNEL_SETS; instruction_set++)
+    {
+        kernels = NULL;
+        if (instruction_set >= 0)
+        {
+            if (!select_kernels(instruction_set))
+                continue;
+            kernels = get_kernels();
+        }
+
+        same = 1;
+        for (repetition = 0; repetition < repetitions; repetition++)
+        {
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (pass = 0; pass < KERNEL_BENCHMARK_PASSES; pass++)
+            {
+                for (set = 0; set < num_sets; set++)
+                {
+                    for (core_no = 0; core_no < total_cores; core_no++)
+                    {
+                        if (kernels == NULL)
+                            scan_total_utilisation(task_sets[set], matrix + core_no * total_levels * total_levels, core_no);
+                        else
+                            find_total_utilisation(task_sets[set], processors[set], matrix + core_no * total_levels * total_levels, core_no);
+                    }
+                    if (pass == 0)
+                        same &= (memcmp(matrix, matrices[set], sizeof(double) * matrix_size) == 0);
+                }
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            time = benchmark_seconds(&start, &end);
+            matrix_time[instruction_set + 1] = (repetition == 0) ? time : fmin(matrix_time[instruction_set + 1], time);
+
+            if (kernels == NULL)
+                continue;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (pass = 0; pass < KERNEL_BENCHMARK_PASSES; pass++)
+            {
+                for (set = 0; set < num_sets; set++)
+                {
+                    kernels->find_demand_densities(density, jobs[set], task_sets[set]->total_tasks, times[set]);
+                    if (pass == 0)
+                        same &= (memcmp(density, densities[set], sizeof(double) * task_sets[set]->total_tasks) == 0);
+                }
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            time = benchmark_seconds(&start, &end);
+            density_time[instruction_set + 1] = (repetition == 0) ? time : fmin(density_time[instruction_set + 1], time);
+        }
+
+        failed |= !same;
+        if (kernels == NULL)
+            printf("%-8s %-11.1lf %-8.2lf %-11s %-8s %s\n", "scan", matrix_time[0] * 1e9 / KERNEL_BENCHMARK_PASSES / num_sets, 1.00, "-", "-", same ? "same" : "DIFFERENT");
+        else
+            printf("%-8s %-11.1lf %-8.2lf %-11.1lf %-8.2lf %s\n", kernels->name, matrix_time[instruction_set + 1] * 1e9 / KERNEL_BENCHMARK_PASSES / num_sets,
+                   matrix_time[0] / matrix_time[instruction_set + 1], density_time[instruction_set + 1] * 1e9 / KERNEL_BENCHMARK_PASSES / num_sets,
+                   density_time[KERNELS_SCALAR + 1] / density_time[instruction_set + 1], same ? "same" : "DIFFERENT");
+    }
+    printf("The times are per taskset: the utilisation matrices of all its cores, and the demand densities of its jobs.\n");
+
+    for (set = 0; set < num_sets; set++)
+    {
+        free(matrices[set]);
+        free(densities[set]);
+    }
+    free(matrices);
+    free(densities);
+    free(matrix);
+    free(density);
+
+    return failed;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the generator, pointer to the options, the number of cores, the number of tasksets, the number of repetitions}
+                The target utilisations of the generator are set.
+
+    Purpose of the function: Runs the kernel benchmark on the tasksets of the generator that are partitioned onto the cores. The jobs of a taskset are the first job
+                             of each of its tasks, and their densities are found at the deadline of a quarter of them, so that some of the jobs are past their deadline.
+                             The kernels in use are then selected again, as they would be without the benchmark.
+
+    Postconditions:
+        Output: {0 if every instruction set gave the results of the baselines, 1 otherwise}
+*/
+int run_kernel_benchmark(generator_struct *generator, options_struct *options, int total_cores, int sets, int repetitions)
+{
+    task_set_struct **task_sets = (task_set_struct **)malloc(sizeof(task_set_struct *) * sets);
+    processor_struct **processors = (processor_struct **)malloc(sizeof(processor_struct *) * sets);
+    double **jobs = (double **)malloc(sizeof(double *) * sets);
+    double *times = (double *)malloc(sizeof(double) * sets);
+    FILE *null_sink = fopen("/dev/null", "w");
+    task_set_struct *task_set;
+    int num_sets = 0, set, i, failed = 1;
+
+    for (set = 0; set < sets; set++)
+    {
+        generator->set_number = set;
+        task_set = generate_taskset(generator);
+        if (task_set == NULL)
+            continue;
+        processors[num_sets] = initialize_processor(total_cores, task_set->total_levels);
+        set_processor_options(processors[num_sets], options);
+        processors[num_sets]->output_file = null_sink;
+        if (!allocate_tasks_to_cores(task_set, processors[num_sets], NULL))
+        {
+            free_processor(processors[num_sets]);
+            free_taskset(task_set);
+            continue;
+        }
+
+        task_sets[num_sets] = task_set;
+        jobs[num_sets] = (double *)malloc(sizeof(double) * 2 * max_int(task_set->total_tasks, 1));
+        for (i = 0; i < task_set->total_tasks; i++)
+        {
+            jobs[num_sets][2 * i] = task_set->phase_table[i] + task_set->task_list[i].virtual_deadline;
+            jobs[num_sets][2 * i + 1] = task_set->task_list[i].WCET[task_set->task_list[i].criticality_lvl];
+        }
+        times[num_sets] = (task_set->total_tasks > 0) ? jobs[num_sets][2 * (task_set->total_tasks / 4)] : 0;
+        num_sets++;
+    }
+
+    printf("Kernel benchmark: %d of %d tasksets of %d tasks and %d levels partitioned onto %d cores, %d passes of each repetition\n",
+           num_sets, sets, generator->total_tasks, generator->total_levels, total_cores, KERNEL_BENCHMARK_PASSES);
+    if (num_sets > 0)
+    {
+        failed = time_kernels(task_sets, processors, jobs, times, num_sets, repetitions);
+        select_kernels(-1);
+    }
+
+    for (set = 0; set < num_sets; set++)
+    {
+        free(jobs[set]);
+        free_processor(processors[set]);
+        free_taskset(task_sets[set]);
+    }
+    free(task_sets);
+    free(processors);
+    free(jobs);
+    free(times);
+    fclose(null_sink);
+
+    return failed;
+}
+
+int main(int argc, char *argv[])
+{
+    generator_struct generator;
+    options_struct options;
+    benchmark_point_struct point, total;
+    double cores_list[MAX_BENCHMARK_CORES] = {1, 2, 4};
+    double sweep[3] = {0.10, 1.00, 0.10};
+    double util, simulation_time;
+    int num_cores = 3, sets = 100, repetitions = 3, simulate = 1, kernel_benchmark = 0;
+    int total_sets = 0, option, c, set, repetition, num_point = 0;
+
+    initialize_generator(&generator);
+    generator.total_tasks = 20;
+    options.total_cores = 0;
+    options.allocation = ALLOCATION_WFD;
+    options.governor = DVFS_NONE;
+    options.shutdown_threshold = -1;
+    options.exec_time_type = EXEC_TIME_SAMPLER;
+    options.seed = 1;
+    options.fraction = 0.50;
+    options.overrun_probability = 0.10;
+    options.continue_on_miss = 0;
+    options.migration = MIGRATION_NONE;
+    options.mode_switch_cluster = 0;
+    options.threads = 1;
+
+    while ((option = getopt(argc, argv, "n:L:S:u:m:s:r:AKP:Q:W:J:Xg:z:p:f:R:h")) != -1)
+    {
+        switch (option)
+        {
+        case 'n':
+            generator.total_tasks = max_int(atoi(optarg), 1);
+            break;
+        case 'L':
+            generator.total_levels = min_int(max_int(atoi(optarg), 1), GENERATOR_MAX_LEVELS);
+            break;
+        case 'S':
+            sets = max_int(atoi(optarg), 1);
+            break;
+        case 'u':
+            for (char *p = optarg; *p != '\0'; p++)
+            {
+                if (*p == ':')
+                    *p = ',';
+            }
+            if (parse_double_list(optarg, sweep, 3) != 3 || sweep[2] <= 0)
+            {
+                printf("ERROR: Invalid utilisation sweep %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'm':
+            num_cores = parse_double_list(optarg, cores_list, MAX_BENCHMARK_CORES);
+            if (num_cores <= 0)
+            {
+                printf("ERROR: Invalid number of cores %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 's':
+            options.seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'r':
+            repetitions = max_int(atoi(optarg), 1);
+            break;
+        case 'A':
+            simulate = 0;
+            break;
+        case 'K':
+            options.continue_on_miss = 1;
+            break;
+        case 'P':
+            if (strcmp(optarg, "ffd") == 0)
+                options.allocation = ALLOCATION_FFD;
+            else if (strcmp(optarg, "ca-tpa") == 0)
+                options.allocation = ALLOCATION_CA_TPA;
+            else
+                options.allocation = ALLOCATION_WFD;
+            break;
+        case 'Q':
+            options.migration = (strcmp(optarg, "semi") == 0) ? MIGRATION_SEMI_PARTITIONED : MIGRATION_NONE;
+            break;
+        case 'W':
+            options.mode_switch_cluster = (strcmp(optarg, "global") == 0) ? 0 : ((strcmp(optarg, "core") == 0) ? 1 : max_int(atoi(optarg), 0));
+            break;
+        case 'J':
+            options.threads = max_int(atoi(optarg), 1);
+            break;
+        case 'X':
+            kernel_benchmark = 1;
+            break;
+        case 'g':
+            options.governor = (strcmp(optarg, "cc") == 0) ? DVFS_CYCLE_CONSERVING : DVFS_NONE;
+            break;
+        case 'z':
+            options.shutdown_threshold = max_tick(UNITS_TO_TICKS(atof(optarg)), 0);
+            break;
+        case 'p':
+            options.overrun_probability = atof(optarg);
+            break;
+        case 'f':
+            options.fraction = atof(optarg);
+            break;
+        case 'R':
+            if (!parse_period_distribution(&generator, optarg))
+            {
+                printf("ERROR: Invalid period distribution %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            print_benchmark_usage(argv[0]);
+            return (option == 'h') ? 0 : 1;
+        }
+    }
+    generator.seed = options.seed;
+
+    if (kernel_benchmark)
+    {
+        for (int level = 0; level < generator.total_levels; level++)
+        {
+            generator.target_util[level] = sweep[0] * max_int((int)cores_list[0], 1);
+        }
+        return run_kernel_benchmark(&generator, &options, max_int((int)cores_list[0], 1), sets, repetitions);
+    }
+
+    memset(&total, 0, sizeof(total));
+    printf("%-6s %-6s %-6s %-8s %-7s %-7s %-9s %-9s %-11s %-11s %-9s %-10s %-11s %-10s %s\n",
+           "cores", "util", "sets", "accepted", "ratio", "misses", "discard", "migrate", "disc_avail", "disc_exec", "recovery", "decisions", "alloc_us", "sim_s", "decisions/s");
+
+    for (c = 0; c < num_cores; c++)
+    {
+        //The small epsilon keeps the last point of the sweep despite the rounding of the steps.
+        for (util = sweep[0]; util <= sweep[1] + 1e-9; util += sweep[2], num_point++)
+        {
+            memset(&point, 0, sizeof(point));
+            point.total_cores = max_int((int)cores_list[c], 1);
+            point.util = util;
+            for (int level = 0; level < generator.total_levels; level++)
+            {
+                generator.target_util[level] = util * point.total_cores;
+            }
+
+            for (set = 0; set < sets; set++)
+            {
+                //Each point draws its own tasksets, whatever the order of the sweep.
+                generator.set_number = (uint64_t)num_point * sets + set;
+                simulation_time = 0.00;
+                for (repetition = 0; repetition < repetitions; repetition++)
+                {
+                    double time = run_benchmark_taskset(&generator, &options, &point, simulate, repetition == 0);
+                    simulation_time = (repetition == 0) ? time : fmin(simulation_time, time);
+                    if (!simulate)
+                        break;
+                }
+                point.simulation_time += simulation_time;
+            }
+
+            printf("%-6d %-6.2lf %-6d %-8d %-7.3lf %-7d %-9d %-9d %-11.2lf %-11.2lf %-9.3lf %-10ld %-11.2lf %-10.4lf %.0lf\n",
+                   point.total_cores, point.util, sets, point.accepted, (double)point.accepted / sets,
+                   point.deadline_misses, point.discarded_jobs, point.migrations, point.discarded_jobs_available, point.discarded_jobs_executed,
+                   (point.discarded_jobs_available > 0) ? point.discarded_jobs_executed / point.discarded_jobs_available : 0.00,
+                   point.decisions, point.allocation_time * 1e6 / sets, point.simulation_time,
+                   (point.simulation_time > 0) ? point.decisions / point.simulation_time : 0.00);
+
+            total.accepted += point.accepted;
+            total_sets += sets;
+            total.deadline_misses += point.deadline_misses;
+            total.decisions += point.decisions;
+            total.allocation_time += point.allocation_time;
+            total.simulation_time += point.simulation_time;
+        }
+    }
+
+    printf("Total: %d of %d tasksets accepted, %d deadline misses, %ld decisions in %.4lf s (%.0lf decisions/s), %.2lf us per partitioning\n",
+           total.accepted, total_sets, total.deadline_misses, total.decisions, total.simulation_time,
+           (total.simulation_time > 0) ? total.decisions / total.simulation_time : 0.00, total.allocation_time * 1e6 / max_int(total_sets, 1));
+
+    return 0;
+}
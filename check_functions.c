@@ -1,51 +1,56 @@
 #include "functions.h"
 
-void find_total_utilisation(int total_tasks, task *tasks_list, double total_utilisation[][MAX_CRITICALITY_LEVELS], int core_no)
+/*
+    Preconditions:
+        Input: {pointer to taskset, pointer to processor, utilisation matrix to fill, the core number}
+                The tasks of the core are indexed (see initialize_task_index).
+
+    Purpose of the function: Finds the utilisation matrix of a core. total_utilisation[l * total_levels + k] is the utilisation at level k of the tasks of criticality level l.
+                             The tasks of each level of the core are contiguous in its task index, so row l of the matrix is the sum of their rows of the utilisation table,
+                             added by the kernels in one pass over the tasks of the core without testing their core or level.
+                             The tasks are added in the order of their numbers, so each entry is the same whatever the instruction set of the kernels.
+
+    Postconditions:
+        Output: {void}
+*/
+void find_total_utilisation(task_set_struct *task_set, processor_struct *processor, double *total_utilisation, int core_no)
 {
-    int i, l, k;
+    core_struct *core = &processor->cores[core_no];
+    kernel_struct *kernels = get_kernels();
+    int total_levels = task_set->total_levels;
+    int l;
 
-    for (l = 0; l < MAX_CRITICALITY_LEVELS; l++)
+    for (l = 0; l < total_levels * total_levels; l++)
     {
-        for (k = 0; k < MAX_CRITICALITY_LEVELS; k++)
-        {
-            total_utilisation[l][k] = 0;
-            for (i = 0; i < total_tasks; i++)
-            {
-                if (tasks_list[i].criticality_lvl == l && tasks_list[i].core == core_no)
-                {
-                    total_utilisation[l][k] += tasks_list[i].util[k];
-                }
-            }
-        }
+        total_utilisation[l] = 0;
+    }
+
+    for (l = 0; l < total_levels; l++)
+    {
+        kernels->add_rows(total_utilisation + l * total_levels, task_set->util_table, core->task_index + core->level_index[l], core->level_index[l + 1] - core->level_index[l], total_levels);
     }
 
     return;
 }
 
 /*
-    Preconditions:  
-        Input: {pointer to taskset, file pointer to output file}
-
-    Purpose of the function: This function checks whether the taskset is schedulable or not. The taskset is schedulable if:
-                            U[LOW][LOW] + U[HIGH][HIGH] <= 1 ====> This implies that taskset can be scheduled according to EDF only.
-                            U[LOW][LOW] + x*U[HIGH][HIGH] <= 1 ====> This implies that EDF-VD is required.
-                            If the taskset is schedulable, then compute the virtual deadlines of all the tasks according to their criticality levels.
-
-    Postconditions: 
-        Output: {if taskset is schedulable, return 1. Else return 0}
-        Result: The taskset is checked for schedulability and the virtual deadlines of all the tasks is calculated.
+    Preconditions:
+        Input: {utilisation matrix of a core, number of criticality levels}
+                total_utilisation[l * total_levels + k] is the utilisation at level k of the tasks of criticality level l
+
+    Purpose of the function: This function checks whether the tasks with the given utilisation matrix are schedulable on a core under EDF-VD. They are schedulable if:
+                            The utilisation at each level of the tasks of at least that criticality is at most 1 ====> The tasks are feasible.
+                            The sum of the utilisations of the tasks at their own criticality levels is at most 1 ====> The tasks can be scheduled according to EDF only.
+                            x * U[LOW][LOW] + U[HIGH][HIGH] <= 1 for some threshold k, with LOW the levels up to k and HIGH the levels above it ====> EDF-VD is required.
+                            The cost is O(L^2) in the number of levels, whatever the number of tasks.
+
+    Postconditions:
+        Output: {The x factor and the threshold level k. x is 0 if the tasks are not schedulable}
 */
-x_factor_struct check_schedulability(task_set_struct *task_set, int core_no)
+x_factor_struct find_x_factor(double *total_utilisation, int total_levels)
 {
-    // fprintf(output_file, "\n--------------SCHEDULABILITY CHECKS------------\n");
-
-    double total_utilisation[MAX_CRITICALITY_LEVELS][MAX_CRITICALITY_LEVELS];
-    int total_tasks = task_set->total_tasks;
-    task *tasks_list = task_set->task_list;
-
     double x, check1;
     double check_utilisation = 0.0;
-    int check_feasibility = 1;
     int criticality_lvl;
     int i, j;
     double util_LO_LO = 0.0;
@@ -53,37 +58,29 @@ x_factor_struct check_schedulability(task_set_struct *task_set, int core_no)
     double util_HI_LO = 0.0;
     x_factor_struct x_factor;
 
-    find_total_utilisation(total_tasks, tasks_list, total_utilisation, core_no);
-    // print_total_utilisation(total_utilisation);
+    x_factor.k = 0;
 
     //Condition to be checked for feasible tasksets. The total utilisation at each criticality level should be less than 1.
-    for (i = 0; i < MAX_CRITICALITY_LEVELS; i++)
+    for (i = 0; i < total_levels; i++)
     {
         check_utilisation = 0.0;
-        for (j = i; j < MAX_CRITICALITY_LEVELS; j++)
+        for (j = i; j < total_levels; j++)
         {
-            check_utilisation += total_utilisation[j][i];
+            check_utilisation += total_utilisation[j * total_levels + i];
         }
 
         //If check_utilisation is greater than 1, the task set is not feasible on unit speed processor.
         if (check_utilisation > 1)
         {
-            check_feasibility = 0;
-            break;
+            x_factor.x = 0.00;
+            return x_factor;
         }
     }
 
-    //If check_feasibility is zero, then the taskset is not feasible on a unit speed processor.
-    if (check_feasibility == 0)
-    {
-        x_factor.x = 0.00;
-        return x_factor;
-    }
-
     check_utilisation = 0.0;
-    for (criticality_lvl = 0; criticality_lvl < MAX_CRITICALITY_LEVELS; criticality_lvl++)
+    for (criticality_lvl = 0; criticality_lvl < total_levels; criticality_lvl++)
     {
-        check_utilisation += total_utilisation[criticality_lvl][criticality_lvl];
+        check_utilisation += total_utilisation[criticality_lvl * total_levels + criticality_lvl];
     }
 
     //If all tasks are able to execute the worst case execution time of their respective criticality level, that is, check_utilisation <= 1
@@ -91,12 +88,12 @@ x_factor_struct check_schedulability(task_set_struct *task_set, int core_no)
     if (check_utilisation <= 1)
     {
         x_factor.x = 1.00;
-        x_factor.k = MAX_CRITICALITY_LEVELS - 1;
+        x_factor.k = total_levels - 1;
         return x_factor;
     }
 
     //We find the first k for which the required condition is satisfied. Condition given in 2015 Baruah's paper - Page 10, Section 3.2
-    for (criticality_lvl = 0; criticality_lvl < MAX_CRITICALITY_LEVELS - 1; criticality_lvl++)
+    for (criticality_lvl = 0; criticality_lvl < total_levels - 1; criticality_lvl++)
     {
         x = 0.00;
         check1 = 0.00;
@@ -108,24 +105,22 @@ x_factor_struct check_schedulability(task_set_struct *task_set, int core_no)
         //Calculating the required quantities as specified in paper.
         for (j = 0; j <= criticality_lvl; j++)
         {
-            util_LO_LO += total_utilisation[j][j];
+            util_LO_LO += total_utilisation[j * total_levels + j];
         }
 
         if (util_LO_LO > 1)
             continue;
 
-        for (j = criticality_lvl + 1; j < MAX_CRITICALITY_LEVELS; j++)
+        for (j = criticality_lvl + 1; j < total_levels; j++)
         {
-            util_HI_HI += total_utilisation[j][j];
-            util_HI_LO += total_utilisation[j][criticality_lvl];
+            util_HI_HI += total_utilisation[j * total_levels + j];
+            util_HI_LO += total_utilisation[j * total_levels + criticality_lvl];
         }
 
         x = (double)util_HI_LO / (double)(1 - util_LO_LO);
 
         check1 = x * util_LO_LO + util_HI_HI;
 
-        // fprintf(output_file, "crit_level: %d, util_LO_LO: %.2lf, util_HI_HI: %.2lf, util_HI_LO: %.2lf, x: %.2lf, check1: %.2lf\n", criticality_lvl, util_LO_LO, util_HI_HI, util_HI_LO, x, check1);
-
         if (check1 <= 1.00)
         {
             x_factor.x = x;
@@ -138,3 +133,87 @@ x_factor_struct check_schedulability(task_set_struct *task_set, int core_no)
     x_factor.x = 0.00;
     return x_factor;
 }
+
+/*
+    Preconditions:  
+        Input: {pointer to taskset, pointer to processor, the core number}
+                The tasks of the core are indexed (see initialize_task_index).
+
+    Purpose of the function: This function checks whether the tasks allocated to the core are schedulable under EDF-VD, from the utilisation matrix found by find_total_utilisation.
+                            The test itself is find_x_factor. A core whose utilisation matrix is kept with add_task_to_core can be checked without finding it.
+
+    Postconditions: 
+        Output: {The x factor and the threshold level k. x is 0 if the tasks are not schedulable}
+*/
+x_factor_struct check_schedulability(task_set_struct *task_set, processor_struct *processor, int core_no)
+{
+    int total_levels = task_set->total_levels;
+    double total_utilisation[total_levels * total_levels];
+
+    find_total_utilisation(task_set, processor, total_utilisation, core_no);
+
+    return find_x_factor(total_utilisation, total_levels);
+}
+
+/*
+    Function to add the utilisations of a task to the utilisation matrix and the remaining utilisations of a core, or to subtract them if sign is -1.
+*/
+void update_core_utilisation(core_struct *core, task *curr_task, int total_levels, int sign)
+{
+    int k;
+
+    for (k = 0; k < total_levels; k++)
+    {
+        core->utilisation[curr_task->criticality_lvl * total_levels + k] += sign * curr_task->util[k];
+        if (k <= curr_task->criticality_lvl)
+            core->rem_util[k] -= sign * curr_task->util[k];
+    }
+    core->num_tasks_allocated += sign;
+}
+
+/*
+    Function to allocate a task to a core. The utilisation matrix of the core is updated in O(L), so the core can be checked with find_x_factor without scanning the taskset.
+*/
+void add_task_to_core(processor_struct *processor, task *curr_task, int core_no)
+{
+    curr_task->core = core_no;
+    update_core_utilisation(&processor->cores[core_no], curr_task, processor->total_levels, 1);
+}
+
+/*
+    Function to remove a task from its core. The utilisation matrix of the core is updated in O(L).
+    As the utilisations are subtracted, a core that has had many tasks added and removed may carry a small rounding error in its matrix.
+*/
+void remove_task_from_core(processor_struct *processor, task *curr_task)
+{
+    if (curr_task->core < 0)
+        return;
+    update_core_utilisation(&processor->cores[curr_task->core], curr_task, processor->total_levels, -1);
+    curr_task->core = -1;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to processor, pointer to the task, the core number}
+                The task is not allocated to the core.
+
+    Purpose of the function: Finds the x factor the core would have if the task were added to it, without changing the core.
+                             It is the admission test of the partitioning, and costs O(L^2) in the number of levels.
+
+    Postconditions:
+        Output: {The x factor and the threshold level k. x is 0 if the core would not be schedulable}
+*/
+x_factor_struct check_task_admission(processor_struct *processor, task *curr_task, int core_no)
+{
+    int total_levels = processor->total_levels;
+    double total_utilisation[total_levels * total_levels];
+    int k;
+
+    memcpy(total_utilisation, processor->cores[core_no].utilisation, sizeof(double) * total_levels * total_levels);
+    for (k = 0; k < total_levels; k++)
+    {
+        total_utilisation[curr_task->criticality_lvl * total_levels + k] += curr_task->util[k];
+    }
+
+    return find_x_factor(total_utilisation, total_levels);
+}
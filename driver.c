@@ -1,67 +1,342 @@
 #include "functions.h"
 
+void print_usage(char *program)
+{
+    printf("Usage: %s [-i input.txt] [-e input_times.txt] [-a input_allocation.txt] [-k input_cores.txt] [-m cores] [-b taskset.bin] [-c taskset.bin]\n", program);
+    printf("          [-x trace|sample|fraction] [-s seed] [-f fraction] [-p overrun_probability] [-K] [-B batch.txt] [-j threads] [-o summary.txt]\n");
+    printf("          [-t trace_level] [-T text|binary] [-D output_0.trace] [-g none|cc] [-z threshold] [-P file|ffd|wfd|ca-tpa] [-Q partitioned|semi]\n");
+    printf("          [-W global|core|cluster_size] [-J threads]\n");
+    printf("          [-G tasks] [-U util,...] [-M mix,...] [-R log|harmonic[:min:max[:granularity]]] [-C] [-S statistics.csv]\n");
+    printf("  -i, -e, -a: Text files with the tasks, the execution times of the jobs and the task to core mapping.\n");
+    printf("  -k: Text file with the x factor and criticality threshold of each core (default ../input_cores.txt).\n");
+    printf("  -m: Number of cores of the processor. By default there is one core for each entry of the cores file, cores without an entry are shut down.\n");
+    printf("  -b: Read the taskset from a binary taskset file instead of the text files.\n");
+    printf("  -c: Convert the text files (or the generated taskset) to a binary taskset file and exit.\n");
+    printf("  -C: Write the binary (-b) or generated taskset to the text files given by -i and -e and exit.\n");
+    printf("  -x: Source of the execution times of the jobs. trace (default) reads them from the input, sample draws them with the given seed,\n");
+    printf("      overrun probability and lower WCET fraction, fraction uses the given fraction of the LO criticality WCET.\n");
+    printf("  -B: Simulate every taskset listed in the batch file on -j threads and write one summary table to -o.\n");
+    printf("      Each line is either \"input.txt input_times.txt input_allocation.txt input_cores.txt\" or \"taskset.bin input_cores.txt\".\n");
+    printf("  -K: Keep simulating after a deadline miss. By default the simulation ends at the first miss.\n");
+    printf("  -S: Also write the named counters and the histograms of the response times, lateness, preemptions per job, ready queue depths and decision point latencies\n");
+    printf("      of each core and of the whole run, and the histograms of the response time, slack and tardiness of each task, to a CSV file,\n");
+    printf("      or to a JSON file if the name ends in .json. In batch mode each taskset is a run of the file.\n");
+    printf("  -t: Level of the schedule written for each core: 0 none, 1 decision points, 2 job arrivals and discarded jobs, 3 slack computations (default).\n");
+    printf("  -T: binary writes the schedule of each core to output_<core>.trace without formatting it. -D decodes such a file to the text schedule.\n");
+    printf("  -g: Frequency governor of the cores. none (default) runs every core at the maximum frequency, cc selects the lowest frequency keeping the core schedulable (cycle-conserving).\n");
+    printf("  -z: Shut an idle core down when it can procrastinate its next jobs for at least threshold time units. By default the cores are never shut down.\n");
+    printf("  -P: Allocation of the tasks to the cores. file (default) reads it from the allocation and cores files. ffd, wfd and ca-tpa partition the tasks\n");
+    printf("      first-fit, worst-fit or criticality-aware with the EDF-VD schedulability test and find the x factor and K value of each core. Only -m or the\n");
+    printf("      number of entries of the cores file is then taken from the input.\n");
+    printf("  -Q: semi puts the jobs discarded at a criticality change in a pool shared by the cores, from which they migrate to any core with enough slack.\n");
+    printf("      partitioned (default) keeps them on their own core.\n");
+    printf("  -W: Cores that change their criticality level together. global (default) raises the level of every core at an overrun, core only the level\n");
+    printf("      of the overrunning core, and a number the level of its cluster of that many consecutive cores.\n");
+    printf("  -J: Simulate the cores of a partitioned processor on the given number of threads (default 1). The cores run in parallel up to the earliest time\n");
+    printf("      at which any of them can change its criticality level, and the schedules are the same as with one thread.\n");
+    printf("  -G: Generate a taskset of the given number of tasks from the seed (-s) instead of reading it. -U gives the target utilisation at each level of the tasks\n");
+    printf("      of at least that criticality (default 0.5,0.5, one value per level), -M the share of the tasks at each level (default equal shares) and -R the\n");
+    printf("      distribution of the periods (default harmonic:10:1000, log-uniform periods give long hyperperiods unless the granularity is coarse).\n");
+    printf("      The execution times are sampled (-p, -f) and the tasks are partitioned (default -P wfd).\n");
+}
+
 int main(int argc, char *argv[])
 {
     FILE *statistics_file;
+    input_files_struct input_files;
+    char *convert_file = NULL;
+    char *batch_file = NULL;
+    char *summary_file = "summary.txt";
+    char *stats_file = NULL;
+    int num_threads = 1;
+    int trace_level = TRACE_VERBOSE;
+    int trace_mode = TRACE_TEXT;
+    options_struct options;
+    generator_struct generator;
+    double values[GENERATOR_MAX_LEVELS];
+    int num_levels = 0, num_mix = 0, write_text = 0;
+    int option;
 
-    //get_task_set function - takes input from input file. Pass file pointer to the function.
-    task_set_struct *task_set = get_taskset();
-    processor_struct *processor = initialize_processor();
-    stats_struct* stats = initialize_stats_struct();
+    options.total_cores = 0;
+    options.allocation = ALLOCATION_FILE;
+    options.governor = DVFS_NONE;
+    options.shutdown_threshold = -1;
+    options.exec_time_type = EXEC_TIME_TRACE;
+    options.seed = 1;
+    options.fraction = 1.00;
+    options.overrun_probability = 0.00;
+    options.continue_on_miss = 0;
+    options.migration = MIGRATION_NONE;
+    options.mode_switch_cluster = 0;
+    options.threads = 1;
 
-    if(task_set == NULL || processor == NULL || stats == NULL)
+    input_files.taskset_file = "input.txt";
+    input_files.exec_times_file = "input_times.txt";
+    input_files.allocation_file = "input_allocation.txt";
+    input_files.binary_file = NULL;
+    input_files.cores_file = "../input_cores.txt";
+    input_files.generator = NULL;
+    initialize_generator(&generator);
+
+    while ((option = getopt(argc, argv, "i:e:a:b:c:Ck:m:x:s:f:p:KB:j:o:S:t:T:D:g:z:P:Q:W:J:G:U:M:R:h")) != -1)
     {
-        printf("Runtime error\n");
+        switch (option)
+        {
+        case 'i':
+            input_files.taskset_file = optarg;
+            break;
+        case 'e':
+            input_files.exec_times_file = optarg;
+            break;
+        case 'a':
+            input_files.allocation_file = optarg;
+            break;
+        case 'b':
+            input_files.binary_file = optarg;
+            break;
+        case 'c':
+            convert_file = optarg;
+            break;
+        case 'C':
+            write_text = 1;
+            break;
+        case 'G':
+            generator.total_tasks = max_int(atoi(optarg), 1);
+            input_files.generator = &generator;
+            break;
+        case 'U':
+            num_levels = parse_double_list(optarg, values, GENERATOR_MAX_LEVELS);
+            if (num_levels <= 0)
+            {
+                printf("ERROR: Invalid utilisations %s\n", optarg);
+                return 1;
+            }
+            generator.total_levels = num_levels;
+            memcpy(generator.target_util, values, sizeof(double) * num_levels);
+            break;
+        case 'M':
+            num_mix = parse_double_list(optarg, values, GENERATOR_MAX_LEVELS);
+            if (num_mix <= 0)
+            {
+                printf("ERROR: Invalid criticality mix %s\n", optarg);
+                return 1;
+            }
+            memcpy(generator.criticality_mix, values, sizeof(double) * num_mix);
+            break;
+        case 'R':
+            if (!parse_period_distribution(&generator, optarg))
+            {
+                printf("ERROR: Invalid period distribution %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'k':
+            input_files.cores_file = optarg;
+            break;
+        case 'm':
+            options.total_cores = max_int(atoi(optarg), 0);
+            break;
+        case 't':
+            trace_level = atoi(optarg);
+            break;
+        case 'T':
+            trace_mode = (strcmp(optarg, "binary") == 0) ? TRACE_BINARY : TRACE_TEXT;
+            break;
+        case 'g':
+            options.governor = (strcmp(optarg, "cc") == 0) ? DVFS_CYCLE_CONSERVING : DVFS_NONE;
+            break;
+        case 'z':
+            options.shutdown_threshold = max_tick(UNITS_TO_TICKS(atof(optarg)), 0);
+            break;
+        case 'P':
+            if (strcmp(optarg, "ffd") == 0)
+                options.allocation = ALLOCATION_FFD;
+            else if (strcmp(optarg, "wfd") == 0)
+                options.allocation = ALLOCATION_WFD;
+            else if (strcmp(optarg, "ca-tpa") == 0)
+                options.allocation = ALLOCATION_CA_TPA;
+            else
+                options.allocation = ALLOCATION_FILE;
+            break;
+        case 'D':
+            return decode_trace(optarg, stdout);
+        case 'B':
+            batch_file = optarg;
+            break;
+        case 'j':
+            num_threads = max_int(atoi(optarg), 1);
+            break;
+        case 'o':
+            summary_file = optarg;
+            break;
+        case 'K':
+            options.continue_on_miss = 1;
+            break;
+        case 'Q':
+            options.migration = (strcmp(optarg, "semi") == 0) ? MIGRATION_SEMI_PARTITIONED : MIGRATION_NONE;
+            break;
+        case 'W':
+            options.mode_switch_cluster = (strcmp(optarg, "global") == 0) ? 0 : ((strcmp(optarg, "core") == 0) ? 1 : max_int(atoi(optarg), 0));
+            break;
+        case 'J':
+            options.threads = max_int(atoi(optarg), 1);
+            break;
+        case 'S':
+            stats_file = optarg;
+            break;
+        case 'x':
+            if (strcmp(optarg, "sample") == 0)
+                options.exec_time_type = EXEC_TIME_SAMPLER;
+            else if (strcmp(optarg, "fraction") == 0)
+                options.exec_time_type = EXEC_TIME_WCET_FRACTION;
+            else
+                options.exec_time_type = EXEC_TIME_TRACE;
+            break;
+        case 's':
+            options.seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'f':
+            options.fraction = atof(optarg);
+            break;
+        case 'p':
+            options.overrun_probability = atof(optarg);
+            break;
+        default:
+            print_usage(argv[0]);
+            return (option == 'h') ? 0 : 1;
+        }
+    }
+
+    //A generated taskset has no trace, so its execution times are sampled, and no allocation file, so it is partitioned.
+    if (input_files.generator != NULL)
+    {
+        if (num_mix != 0 && num_mix != generator.total_levels)
+        {
+            printf("ERROR: The criticality mix has %d values for %d levels\n", num_mix, generator.total_levels);
+            return 1;
+        }
+        generator.seed = options.seed;
+        if (options.exec_time_type == EXEC_TIME_TRACE)
+            options.exec_time_type = EXEC_TIME_SAMPLER;
+        if (options.allocation == ALLOCATION_FILE)
+            options.allocation = ALLOCATION_WFD;
+    }
+
+    //Generated execution times do not need the trace file.
+    if (options.exec_time_type != EXEC_TIME_TRACE && convert_file == NULL && !write_text)
+        input_files.exec_times_file = NULL;
+    //Partitioned tasks do not need the allocation file.
+    if (options.allocation != ALLOCATION_FILE)
+        input_files.allocation_file = NULL;
+
+    //Convert the text files to the binary taskset format. The tasks are written in the order of the input file.
+    //A generated taskset is written with the execution times of its source, and a binary one can be written back to the text files.
+    if (convert_file != NULL || write_text)
+    {
+        task_set_struct *converted_task_set;
+        if (input_files.generator != NULL)
+        {
+            converted_task_set = generate_taskset(&generator);
+            if (converted_task_set != NULL)
+                set_exec_time_source(converted_task_set, options.exec_time_type, options.seed, options.fraction, options.overrun_probability);
+        }
+        else if (write_text && input_files.binary_file != NULL)
+            converted_task_set = read_binary_taskset(input_files.binary_file);
+        else if (!write_text)
+            converted_task_set = read_text_taskset(&input_files);
+        else
+        {
+            printf("ERROR: -C writes a binary or generated taskset, give -b or -G\n");
+            return 1;
+        }
+
+        if (converted_task_set == NULL)
+            return 1;
+        if (convert_file != NULL && write_binary_taskset(converted_task_set, convert_file) == 0)
+            return 1;
+        if (write_text && write_text_taskset(converted_task_set, &input_files) == 0)
+            return 1;
+        printf("Converted %d tasks to %s\n", converted_task_set->total_tasks, (convert_file != NULL) ? convert_file : input_files.taskset_file);
+        free_taskset(converted_task_set);
         return 0;
     }
 
-    //Set the frequency values.
-    frequency[0] = 0.5;
-    frequency[1] = 0.6;
-    frequency[2] = 0.75;
-    frequency[3] = 0.9;
-    frequency[4] = 1.00;
+    //Batch mode: simulate all the tasksets of the batch file on a pool of threads.
+    if (batch_file != NULL)
+    {
+        return run_batch(batch_file, summary_file, stats_file, num_threads, &options);
+    }
+
+    //get_task_set function - takes input from the input files given on the command line.
+    task_set_struct *task_set = get_taskset(&input_files);
+    if (task_set != NULL && options.exec_time_type != EXEC_TIME_TRACE)
+        set_exec_time_source(task_set, options.exec_time_type, options.seed, options.fraction, options.overrun_probability);
+    if (options.total_cores == 0)
+        options.total_cores = find_total_cores(input_files.cores_file);
+
+    if (task_set == NULL || options.total_cores == 0)
+    {
+        printf("Runtime error\n");
+        return 0;
+    }
+    processor_struct *processor = initialize_processor(options.total_cores, task_set->total_levels);
+    processor->stats = initialize_stats_struct(processor->total_cores);
+    set_processor_options(processor, &options);
+    stats_struct *stats = processor->stats;
+    stats->record_latency = (stats_file != NULL);
+    stats->record_tasks = (stats_file != NULL);
 
     //Open the output file here.
     for (int i = 0; i < processor->total_cores; i++)
     {
-        char filename[15] = "output_";
-        char ext[2];
-        sprintf(ext, "%d", i);
-        strcat(filename, ext);
-        strcat(filename, ".txt");
+        char filename[32];
+        FILE *output;
+        sprintf(filename, (trace_mode == TRACE_BINARY) ? "output_%d.trace" : "output_%d.txt", i);
 
-        output[i] = fopen(filename, "w");
+        output = fopen(filename, "w");
+        if (output == NULL)
+        {
+            printf("ERROR: Cannot open output file. Make sure right permissions are provided\n");
+            return 0;
+        }
 
-        fprintf(output[i], "Schedule for core %d\n", i);
+        processor->cores[i].trace = initialize_trace(output, trace_level, trace_mode);
+        TRACE(processor->cores[i].trace, TRACE_DECISIONS, "Schedule for core %d\n", i);
     }
-    output_file = fopen("output.txt", "w");
-    if (output_file == NULL)
+    processor->output_file = fopen("output.txt", "w");
+    if (processor->output_file == NULL)
     {
         printf("ERROR: Cannot open output file. Make sure right permissions are provided\n");
         return 0;
     }
 
+    srand(time(NULL));
+
     printf("Starting runtime scheduling\n");
-    runtime_scheduler(task_set, processor);
+    runtime_scheduler(task_set, processor, input_files.cores_file);
 
     statistics_file = fopen("statistics.txt", "w");
-    for (int i = 0; i < NUM_CORES; i++)
+    for (int i = 0; i < processor->total_cores; i++)
     {
-        fprintf(statistics_file, "%.2lf %.2lf %.2lf %d %d %.2lf %.2lf\n", 
+        fprintf(statistics_file, "%.2lf %.2lf %.2lf %d %d %.2lf %.2lf %d\n", 
                 stats->total_active_energy[i],
                 stats->total_idle_energy[i],
                 stats->total_shutdown_time[i],
                 stats->total_discarded_jobs[i],
                 stats->total_completion_points[i],
                 stats->total_discarded_jobs_executed[i],
-                stats->total_discarded_jobs_available[i]);
+                stats->total_discarded_jobs_available[i],
+                stats->total_frequency_switches[i]);
     }
 
     fclose(statistics_file);
-    for (int i = 0; i < NUM_CORES; i++)
-    {
-        fclose(output[i]);
-    }
-    fclose(output_file);
+
+    if (stats_file != NULL)
+        write_stats_file(stats_file, (input_files.generator != NULL) ? "generated" : ((input_files.binary_file != NULL) ? input_files.binary_file : input_files.taskset_file), stats);
+    fclose(processor->output_file);
+
+    free_stats_struct(processor->stats);
+    free_processor(processor);
+    free_taskset(task_set);
+    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "functions.h"
+
+/*
+    Function to find the cycles executed by a core running at the given frequency for the given time.
+    The cycles are counted in ticks at the maximum frequency, so at frequency 1 they are equal to the time.
+*/
+tick_t find_executed_cycles(tick_t time, double frequency)
+{
+    return (tick_t)llround(time * frequency);
+}
+
+/*
+    Function to find the time needed by a core running at the given frequency to execute the given cycles. The time is rounded up to a tick.
+*/
+tick_t find_execution_duration(tick_t cycles, double frequency)
+{
+    return (tick_t)ceil(cycles / frequency);
+}
+
+/*
+    Function to find the energy spent by a core executing for the given time at the given frequency.
+*/
+double find_active_energy(tick_t time, double frequency)
+{
+    return TICKS_TO_UNITS(time) * ACTIVE_POWER(frequency);
+}
+
+/*
+    Function to set the utilisation the governor accounts for a task, and update the sum of its core.
+*/
+void set_dvfs_util(core_struct *core, task *curr_task, double util)
+{
+    core->dvfs_util += util - curr_task->dvfs_util;
+    curr_task->dvfs_util = util;
+}
+
+/*
+    Function to find the utilisation of a job of the task released at the given criticality level. Tasks below the level release no job.
+*/
+double find_release_dvfs_util(task *curr_task, int curr_crit_level)
+{
+    if (curr_task->criticality_lvl < curr_crit_level)
+        return 0.00;
+    return (double)curr_task->WCET[curr_crit_level] / (double)curr_task->virtual_deadline;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to taskset, pointer to processor, the core number}
+                core_no < processor->total_cores
+
+    Purpose of the function: Sets the utilisation of every task of the core to its WCET at the current criticality level over its virtual deadline.
+                             It is called when the scheduling starts and, after the virtual deadlines are reset, at each criticality change.
+                             The sum of the core is recomputed from the tasks, so no rounding error is carried over from the previous level.
+
+    Postconditions:
+        Output: {void}
+*/
+void initialize_core_dvfs(task_set_struct *task_set, processor_struct *processor, int core_no)
+{
+    core_struct *core = &processor->cores[core_no];
+    task *curr_task;
+    int i;
+
+    core->dvfs_util = 0.00;
+    for (i = 0; i < core->level_index[processor->total_levels]; i++)
+    {
+        curr_task = &task_set->task_list[core->task_index[i]];
+        curr_task->dvfs_util = find_release_dvfs_util(curr_task, core->crit_level);
+        core->dvfs_util += curr_task->dvfs_util;
+    }
+}
+
+/*
+    Function to select the frequency of the core. It is the lowest frequency level at least the utilisation of the core, or the maximum frequency while the core is boosted.
+*/
+double select_core_frequency(core_struct *core)
+{
+    int i;
+
+    if (core->dvfs_boost)
+        return frequency[FREQUENCY_LEVELS - 1];
+
+    for (i = 0; i < FREQUENCY_LEVELS - 1; i++)
+    {
+        if (frequency[i] >= core->dvfs_util - DVFS_UTIL_TOLERANCE)
+            return frequency[i];
+    }
+    return frequency[FREQUENCY_LEVELS - 1];
+}
+
+/*
+    Preconditions:
+        Input: {pointer to processor, the core number}
+                The time of the core and the remaining execution time of its current job are up to date.
+
+    Purpose of the function: Runs the cycle-conserving governor of the core at a decision point. A pending job is accounted at its WCET and a completed job at the cycles it executed,
+                             so the frequency drops when jobs complete early and rises again when the next jobs are released.
+                             EDF-VD on the virtual deadlines stays feasible as long as the frequency is at least the utilisation of the core.
+                             After a criticality change the core runs at the maximum frequency until its ready queue is empty, as the guarantee of EDF-VD in the higher mode assumes full speed.
+                             If the frequency changes, the completion time and WCET counter of the current job are recomputed from the cycles it has left.
+
+    Postconditions:
+        Output: {void}
+        Result: The frequency of the core is updated.
+*/
+void update_core_frequency(processor_struct *processor, int core_no)
+{
+    core_struct *core = &processor->cores[core_no];
+    double new_frequency;
+
+    if (processor->governor == DVFS_NONE || core->state != ACTIVE)
+        return;
+
+    if (core->ready_queue->num_jobs == 0)
+        core->dvfs_boost = 0;
+
+    new_frequency = select_core_frequency(core);
+    if (new_frequency == core->frequency)
+        return;
+
+    core->frequency = new_frequency;
+    processor->stats->total_frequency_switches[core_no]++;
+    TRACE(core->trace, TRACE_DECISIONS, "Frequency: %.2lf, Utilisation: %.5lf\n", core->frequency, core->dvfs_util);
+
+    if (core->curr_exec_job != NULL)
+    {
+        core->curr_exec_job->completion_time = core->total_time + find_execution_duration(core->curr_exec_job->rem_exec_time, core->frequency);
+        core->WCET_counter = core->total_time + find_execution_duration(core->curr_exec_job->WCET_counter, core->frequency);
+    }
+}
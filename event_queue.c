@@ -0,0 +1,176 @@
+#include "functions.h"
+
+/*
+    Function to swap two events in the heap and update their positions.
+*/
+void swap_events(event_heap_struct *heap, int i, int j)
+{
+    event_struct temp = heap->events[i];
+    heap->events[i] = heap->events[j];
+    heap->events[j] = temp;
+
+    heap->position[heap->events[i].id] = i;
+    heap->position[heap->events[j].id] = j;
+}
+
+/*
+    Comparator for the events. Events are ordered on their time and the ties are broken on the id, so that the lower task or core is picked first.
+*/
+int event_less_than(event_struct *A, event_struct *B)
+{
+    if (A->time != B->time)
+        return A->time < B->time;
+    return A->id < B->id;
+}
+
+void sift_up_event(event_heap_struct *heap, int index)
+{
+    int parent;
+
+    while (index > 0)
+    {
+        parent = (index - 1) / 2;
+        if (!event_less_than(&heap->events[index], &heap->events[parent]))
+            break;
+        swap_events(heap, index, parent);
+        index = parent;
+    }
+}
+
+void sift_down_event(event_heap_struct *heap, int index)
+{
+    int left, right, smallest;
+
+    while (1)
+    {
+        left = 2 * index + 1;
+        right = left + 1;
+        smallest = index;
+
+        if (left < heap->num_events && event_less_than(&heap->events[left], &heap->events[smallest]))
+            smallest = left;
+        if (right < heap->num_events && event_less_than(&heap->events[right], &heap->events[smallest]))
+            smallest = right;
+        if (smallest == index)
+            break;
+
+        swap_events(heap, index, smallest);
+        index = smallest;
+    }
+}
+
+/*
+    Preconditions:
+        Input: {maximum number of events in the heap, pointer to the position array (can be NULL)}
+                capacity>0
+
+    Purpose of the function: Creates an empty event heap. The position array maps an id to its slot in the heap.
+                             Heaps whose ids are disjoint (for example the arrival calendars of different cores, which hold different tasks) can share one position array indexed by task number.
+                             If position is NULL, a private position array for the ids [0, capacity) is allocated.
+
+    Postconditions:
+        Output: {Pointer to the event heap}
+*/
+event_heap_struct *initialize_event_heap(int capacity, int *position)
+{
+    int i;
+    event_heap_struct *heap = (event_heap_struct *)malloc(sizeof(event_heap_struct));
+
+    heap->num_events = 0;
+    heap->capacity = capacity;
+    heap->events = (event_struct *)malloc(sizeof(event_struct) * max_int(capacity, 1));
+
+    if (position == NULL)
+    {
+        position = (int *)malloc(sizeof(int) * max_int(capacity, 1));
+        for (i = 0; i < capacity; i++)
+        {
+            position[i] = -1;
+        }
+    }
+    heap->position = position;
+
+    return heap;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the event heap, id of the event, time of the event}
+
+    Purpose of the function: Inserts the event of the given id in the heap. If the id is already present, its time is updated instead.
+                             The cost is O(log n) in the number of events in the heap.
+
+    Postconditions:
+        Output: {void}
+*/
+void update_event(event_heap_struct *heap, int id, tick_t time)
+{
+    int index = heap->position[id];
+    tick_t old_time;
+
+    if (index == -1)
+    {
+        index = heap->num_events++;
+        heap->events[index].id = id;
+        heap->events[index].time = time;
+        heap->position[id] = index;
+        sift_up_event(heap, index);
+        return;
+    }
+
+    old_time = heap->events[index].time;
+    heap->events[index].time = time;
+
+    if (time < old_time)
+        sift_up_event(heap, index);
+    else
+        sift_down_event(heap, index);
+}
+
+/*
+    Function to remove the event of the given id from the heap. It does nothing if the id is not present.
+*/
+void remove_event(event_heap_struct *heap, int id)
+{
+    int index = heap->position[id];
+    int last;
+
+    if (index == -1)
+        return;
+
+    last = --heap->num_events;
+    if (index != last)
+    {
+        swap_events(heap, index, last);
+    }
+    heap->position[id] = -1;
+
+    if (index != last)
+    {
+        sift_up_event(heap, index);
+        sift_down_event(heap, index);
+    }
+}
+
+/*
+    Function to get the earliest event of the heap. Returns NULL if the heap is empty.
+*/
+event_struct *find_min_event(event_heap_struct *heap)
+{
+    if (heap == NULL || heap->num_events == 0)
+        return NULL;
+    return &heap->events[0];
+}
+
+/*
+    Function to free the event heap. The position array is freed only if free_position is set, as it may be shared with other heaps.
+*/
+void free_event_heap(event_heap_struct *heap, int free_position)
+{
+    if (heap == NULL)
+        return;
+    if (free_position)
+        free(heap->position);
+    free(heap->events);
+    free(heap);
+}
@@ -0,0 +1,104 @@
+#include "functions.h"
+
+/*
+    Function to mix the bits of a 64 bit number (splitmix64 finaliser). It is used as a counter based random number generator, so that the sampled execution time of a job does not depend on the order in which the jobs are released.
+*/
+uint64_t mix_bits(uint64_t value)
+{
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+/*
+    Function to get a uniform random number in [0, 1) for the given seed, task and job.
+*/
+double uniform_sample(uint64_t seed, int task_number, int job_number, int draw)
+{
+    uint64_t value = mix_bits(seed ^ mix_bits(((uint64_t)(uint32_t)task_number << 32) | (uint32_t)job_number) ^ (uint64_t)draw);
+    return (value >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the task, the job number}
+                curr_task!=NULL
+                job_number>=0
+
+    Purpose of the function: Produces the actual execution time of the given job of the task from the execution time source of the task.
+                             EXEC_TIME_TRACE: The execution time is read from the window of the trace file, and the window is moved forward when needed.
+                             EXEC_TIME_MAPPED: The execution time is read from the mapped binary taskset file.
+                                               Jobs past the end of a recorded trace replay it from the start. A task without a trace executes for its LO criticality WCET.
+                             EXEC_TIME_SAMPLER: With probability overrun_probability the execution time is drawn uniformly above the LO criticality WCET, up to the WCET at the criticality level of the task.
+                                                Otherwise it is drawn uniformly between fraction and 1 times the LO criticality WCET.
+                             EXEC_TIME_WCET_FRACTION: The execution time is fraction times the LO criticality WCET.
+
+                             The execution times of the traces are in time units and the samples are in ticks, and both are rounded to the nearest tick.
+
+    Postconditions:
+        Output: {The actual execution time of the job in ticks}
+*/
+tick_t find_execution_time(task *curr_task, int job_number)
+{
+    exec_time_source_struct *exec_source = &curr_task->exec_source;
+    tick_t LO_WCET = curr_task->WCET[0];
+    tick_t HI_WCET = curr_task->WCET[curr_task->criticality_lvl];
+    int index;
+
+    switch (exec_source->type)
+    {
+    case EXEC_TIME_TRACE:
+    case EXEC_TIME_MAPPED:
+        if (exec_source->num_exec_times == 0)
+            return LO_WCET;
+
+        index = job_number % exec_source->num_exec_times;
+        if (exec_source->type == EXEC_TIME_MAPPED)
+            return UNITS_TO_TICKS(exec_source->exec_times[index]);
+
+        if (index < exec_source->window_start || index >= exec_source->window_start + exec_source->window_length)
+        {
+            if (read_exec_time_window(exec_source, index) == 0)
+                return LO_WCET;
+        }
+        return UNITS_TO_TICKS(exec_source->exec_times[index - exec_source->window_start]);
+
+    case EXEC_TIME_SAMPLER:
+        if (curr_task->criticality_lvl > 0 && HI_WCET > LO_WCET && uniform_sample(exec_source->seed, curr_task->task_number, job_number, 0) < exec_source->overrun_probability)
+            return LO_WCET + llround((HI_WCET - LO_WCET) * (1.0 - uniform_sample(exec_source->seed, curr_task->task_number, job_number, 1)));
+        return llround(LO_WCET * (exec_source->fraction + (1.0 - exec_source->fraction) * uniform_sample(exec_source->seed, curr_task->task_number, job_number, 1)));
+
+    case EXEC_TIME_WCET_FRACTION:
+        return llround(exec_source->fraction * LO_WCET);
+    }
+
+    return LO_WCET;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to taskset, the type of the source, the seed of the sampler, the WCET fraction, the overrun probability of the sampler}
+                task_set!=NULL
+
+    Purpose of the function: Sets the execution time source of all the tasks to EXEC_TIME_SAMPLER or EXEC_TIME_WCET_FRACTION.
+                             These sources keep no per job state, so the memory used is independent of the number of jobs.
+                             The sampler is keyed on the task number, so it has to be set up after the tasks are numbered.
+
+    Postconditions:
+        Output: {void}
+*/
+void set_exec_time_source(task_set_struct *task_set, int type, uint64_t seed, double fraction, double overrun_probability)
+{
+    int i;
+
+    for (i = 0; i < task_set->total_tasks; i++)
+    {
+        task_set->task_list[i].exec_source.type = type;
+        task_set->task_list[i].exec_source.seed = seed;
+        task_set->task_list[i].exec_source.fraction = fraction;
+        task_set->task_list[i].exec_source.overrun_probability = overrun_probability;
+    }
+
+    return;
+}
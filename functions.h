@@ -6,103 +6,274 @@
 /*---------------------------ALLOCATION FUNCTIONS---------------------------*/
 /*
     Preconditions:
-        Input: {void}
+        Input: {number of cores, number of criticality levels}
+                total_cores>0, total_levels>0
     
     Purpose of the function: It is used to initialize the processors and create the necessary number of cores.
+                             All the per-core and per-level arrays are sized from the arguments.
 
     Postconditions:
         Output: {Pointer to the processor structure}
                 processor!=NULL
 */
-extern processor_struct *initialize_processor();
+extern processor_struct *initialize_processor(int total_cores, int total_levels);
 
 /*
     Preconditions:
-        Input: {Pointer to taskset, pointer to processor}
+        Input: {name of the cores file}
+
+    Purpose of the function: Counts the entries (x factor and K value) of the cores file. The processor has one core for each entry.
+
+    Postconditions:
+        Output: {number of cores, 0 if the file cannot be opened or is empty}
+*/
+extern int find_total_cores(char *cores_file);
+
+extern void set_processor_options(processor_struct *processor, options_struct *options);
+extern int partition_tasks(task_set_struct *task_set, processor_struct *processor);
+extern void initialize_task_index(task_set_struct *task_set, processor_struct *processor);
+
+/*
+    Preconditions:
+        Input: {Pointer to taskset, pointer to processor, name of the cores file}
 
     Purpose of the function: It is used to allocate the tasks to each core.
-                             Priority will be given to high criticality tasks. Each core will be alloted high criticality tasks having a utilization of MAX_HIGH_UTIL (defined in data_structures.h)
+                             With ALLOCATION_FILE the task to core mapping is the one of the input files and the x factor and K value of each core are read from the cores file.
+                             Otherwise the tasks are partitioned by partition_tasks, giving priority to the high criticality tasks, and the x factor and K value of each core are found from its utilisation matrix.
+                             The cores without tasks are shut down and the virtual deadlines of the tasks of the other cores are set.
                             
     Postconditions: 
         Output: If the number of cores is sufficient and all the tasks were allocated to the cores, then it will return 1 to indicate success.
                 Else it will return 0.
 */
-extern int allocate_tasks_to_cores(task_set_struct *task_set, processor_struct *processor);
+extern int allocate_tasks_to_cores(task_set_struct *task_set, processor_struct *processor, char *cores_file);
+
+/*
+    Preconditions:
+        Input: {Pointer to the processor}
+
+    Purpose of the function: It frees the processor, its cores and all the jobs allocated by the cores.
+
+    Postconditions:
+        Output: {void}
+*/
+extern void free_processor(processor_struct *processor);
 /*--------------------------------------------------------------------------*/
 
 /*---------------------------SCHEDULER FUNCTIONS---------------------------*/
 /*
     Preconditions: 
-        Input: {File pointer to input file}
-        fd!=NULL
+        Input: {Pointer to the names of the input files}
+        input_files!=NULL
 
-    Purpose of the function: Takes input from the file and returns a structure of the task set. 
+    Purpose of the function: Takes input from the text files, or from the binary taskset file if one is given, and returns a structure of the task set. 
 
     Postconditions:
         Output: {Pointer to the structure of taskset created}
         task_set!=NULL
     
 */
-extern task_set_struct *get_taskset();
+extern task_set_struct *get_taskset(input_files_struct *input_files);
 
 /*
     Preconditions: 
-        Input: {pointer to taskset, pointer to kernel, pointer to output file}
+        Input: {pointer to taskset, pointer to processor, name of the cores file}
 
     Purpose of the function: This function will perform the offline preprocessing phase and the runtime scheduling of edf-vd.
                              If the taskset is not schedulable, it will return after displaying the same message. Else, it will start the runtime scheduling of the tasket.
                         
     Postconditions: 
-        Output: {void}
+        Output: {1 if the taskset was allocated and scheduled, 0 if it is not schedulable}
 */
-extern void runtime_scheduler(task_set_struct *task_set, processor_struct *processor);
-extern double find_max_slack(task_set_struct *task_set, int crit_level, int core_no, double deadline, double curr_time, job_queue_struct *ready_queue);
-extern double find_superhyperperiod(task_set_struct *task_set);
-extern double find_earliest_arrival_job(task_set_struct *task_set, int core_no, int curr_crit_level);
-extern decision_struct find_decision_point(task_set_struct *task_set, processor_struct *processor, double super_hyperperiod);
-extern void accommodate_discarded_jobs(job_queue_struct **ready_queue, job_queue_struct **discarded_queue, task_set_struct *task_set, int core_no, int curr_crit_level, double curr_time);
-extern void update_job_arrivals(job_queue_struct **ready_queue, job_queue_struct **discarded_queue, task_set_struct *task_set, int curr_crit_level, double curr_time, int core_no, core_struct *core, int timer_expiry);
-extern void update_job_removal(task_set_struct *taskset, job_queue_struct **ready_queue);
+extern int runtime_scheduler(task_set_struct *task_set, processor_struct *processor, char *cores_file);
+extern void schedule_taskset(task_set_struct *task_set, processor_struct *processor);
+extern int process_decision_point(task_set_struct *task_set, processor_struct *processor, decision_struct decision);
+extern void finish_schedule(processor_struct *processor, tick_t super_hyperperiod);
+extern void insert_slack_job(slack_cache_struct *cache, job *new_job);
+extern void remove_slack_job(slack_cache_struct *cache, job *old_job);
+extern void update_slack_job(slack_cache_struct *cache, job *curr_job);
+extern tick_t find_max_slack(task_set_struct *task_set, processor_struct *processor, int crit_level, int core_no, tick_t deadline, tick_t curr_time);
+extern double find_future_demand(task_set_struct *task_set, int num_task, tick_t deadline);
+extern tick_t find_superhyperperiod(task_set_struct *task_set);
+extern tick_t find_earliest_arrival_job(core_struct *core);
+extern void initialize_event_calendar(task_set_struct *task_set, processor_struct *processor);
+extern decision_struct find_core_decision_point(processor_struct *processor, int core_no);
+extern void update_core_decision_point(processor_struct *processor, int core_no);
+extern void find_mode_switch_cluster(processor_struct *processor, int core_no, int *first_core, int *last_core);
+extern decision_struct find_decision_point(task_set_struct *task_set, processor_struct *processor, tick_t super_hyperperiod);
+extern void accommodate_discarded_jobs(job_queue_struct **ready_queue, job_queue_struct **discarded_queue, task_set_struct *task_set, processor_struct *processor, int core_no, int curr_crit_level, tick_t curr_time);
+extern void distribute_discarded_jobs(task_set_struct *task_set, processor_struct *processor, int first_core, int last_core, tick_t curr_time);
+extern void reclaim_discarded_jobs(task_set_struct *task_set, processor_struct *processor, int core_no, tick_t curr_time);
+extern void advance_task_release(task_set_struct *task_set, int num_task);
+extern void update_job_arrivals(job_queue_struct **ready_queue, task_set_struct *task_set, int curr_crit_level, tick_t curr_time, int core_no, core_struct *core, int timer_expiry);
+extern void update_job_removal(task_set_struct *taskset, job_queue_struct **ready_queue, job_pool_struct *job_pool);
 extern void schedule_new_job(core_struct *core, job_queue_struct *ready_queue, task_set_struct *task_set);
 /*-------------------------------------------------------------------------*/
 
 /*---------------------------PROCRASTINATION FUNCTIONS---------------------------*/
-extern double find_procrastination_interval(double curr_time, task_set_struct *task_set, int curr_crit_level, int core_no);
+extern tick_t find_procrastination_interval(tick_t curr_time, task_set_struct *task_set, processor_struct *processor, int curr_crit_level, int core_no);
+extern void update_core_shutdown(task_set_struct *task_set, processor_struct *processor, int core_no);
 /*-------------------------------------------------------------------------------*/
 
 /*---------------------------CHECK FUNCTIONS---------------------------*/
-extern x_factor_struct check_schedulability(task_set_struct *task_set, int core_no);
+extern x_factor_struct find_x_factor(double *total_utilisation, int total_levels);
+extern void find_total_utilisation(task_set_struct *task_set, processor_struct *processor, double *total_utilisation, int core_no);
+extern x_factor_struct check_schedulability(task_set_struct *task_set, processor_struct *processor, int core_no);
+extern void add_task_to_core(processor_struct *processor, task *curr_task, int core_no);
+extern void remove_task_from_core(processor_struct *processor, task *curr_task);
+extern x_factor_struct check_task_admission(processor_struct *processor, task *curr_task, int core_no);
 /*---------------------------------------------------------------------*/
 
 /*---------------------------QUEUE FUNCTIONS---------------------------*/
+extern void insert_job_in_discarded_list(job_queue_struct *discarded_queue, job *new_job, task *task_list);
 extern void insert_job_in_discarded_queue(processor_struct **processor, job *new_job, task *task_list, int core_no);
-extern void remove_jobs_from_discarded_queue(processor_struct **processor, double curr_time);
+extern void remove_expired_jobs(job_queue_struct *discarded_queue, job_pool_struct *job_pool, tick_t curr_time);
+extern void remove_jobs_from_discarded_queue(processor_struct *processor, int core_no, tick_t curr_time);
 extern void insert_job_in_ready_queue(job_queue_struct **ready_queue, job *new_job);
+extern job *remove_min_job_from_ready_queue(job_queue_struct **ready_queue);
+extern job *next_job_in_queue(job *curr);
 extern void remove_jobs_from_ready_queue(job_queue_struct **ready_queue, processor_struct **processor, task *task_list, int curr_crit_lvl, int k, int core_no);
 /*---------------------------------------------------------------------*/
 
+/*---------------------------INPUT FUNCTIONS---------------------------*/
+extern task_set_struct *read_text_taskset(input_files_struct *input_files);
+extern task_set_struct *read_binary_taskset(char *filename);
+extern int write_binary_taskset(task_set_struct *task_set, char *filename);
+extern int write_text_taskset(task_set_struct *task_set, input_files_struct *input_files);
+extern int read_exec_time_window(exec_time_source_struct *exec_source, int job_number);
+extern int fill_exec_time_window(exec_time_source_struct *exec_source, int job_number);
+extern void sort_taskset(task_set_struct *task_set);
+extern void allocate_task_tables(task_set_struct *task_set, int tasks, int levels);
+extern void free_task_tables(task_set_struct *task_set);
+extern void free_taskset(task_set_struct *task_set);
+/*---------------------------------------------------------------------*/
+
+/*---------------------------EXECUTION TIME FUNCTIONS---------------------------*/
+extern uint64_t mix_bits(uint64_t value);
+extern double uniform_sample(uint64_t seed, int task_number, int job_number, int draw);
+extern tick_t find_execution_time(task *curr_task, int job_number);
+extern void set_exec_time_source(task_set_struct *task_set, int type, uint64_t seed, double fraction, double overrun_probability);
+/*---------------------------------------------------------------------*/
+
+/*---------------------------JOB POOL FUNCTIONS---------------------------*/
+extern job_pool_struct *initialize_job_pool();
+extern job *allocate_job(job_pool_struct *job_pool);
+extern void release_job(job_pool_struct *job_pool, job *free_job);
+extern void free_job_pool(job_pool_struct *job_pool);
+/*------------------------------------------------------------------------*/
+
+/*---------------------------EVENT QUEUE FUNCTIONS---------------------------*/
+extern event_heap_struct *initialize_event_heap(int capacity, int *position);
+extern void update_event(event_heap_struct *heap, int id, tick_t time);
+extern void remove_event(event_heap_struct *heap, int id);
+extern event_struct *find_min_event(event_heap_struct *heap);
+extern void free_event_heap(event_heap_struct *heap, int free_position);
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------GENERATOR FUNCTIONS---------------------------*/
+extern void initialize_generator(generator_struct *generator);
+extern int parse_double_list(char *text, double *values, int max_values);
+extern int parse_period_distribution(generator_struct *generator, char *text);
+extern task_set_struct *generate_taskset(generator_struct *generator);
+/*-------------------------------------------------------------------------*/
+
+/*---------------------------DVFS FUNCTIONS---------------------------*/
+extern tick_t find_executed_cycles(tick_t time, double frequency);
+extern tick_t find_execution_duration(tick_t cycles, double frequency);
+extern double find_active_energy(tick_t time, double frequency);
+extern void set_dvfs_util(core_struct *core, task *curr_task, double util);
+extern double find_release_dvfs_util(task *curr_task, int curr_crit_level);
+extern void initialize_core_dvfs(task_set_struct *task_set, processor_struct *processor, int core_no);
+extern void update_core_frequency(processor_struct *processor, int core_no);
+/*--------------------------------------------------------------------*/
+
+/*---------------------------PARALLEL FUNCTIONS---------------------------*/
+extern tick_t find_next_overrun_release(parallel_struct *parallel, int task_number, int crit_level);
+extern tick_t find_core_sync_time(parallel_struct *parallel, int core_no);
+extern void update_core_sync_time(parallel_struct *parallel, int core_no);
+extern tick_t find_parallel_sync_time(parallel_struct *parallel);
+extern void run_core_epoch(parallel_struct *parallel, int core_no);
+extern void *parallel_worker(void *argument);
+extern parallel_struct *start_parallel_schedule(task_set_struct *task_set, processor_struct *processor);
+extern int run_parallel_epoch(parallel_struct *parallel, tick_t epoch_end);
+extern void stop_parallel_schedule(parallel_struct *parallel);
+/*------------------------------------------------------------------------*/
+
+/*---------------------------KERNEL FUNCTIONS---------------------------*/
+extern void add_rows_scalar(double *sum, const double *table, const int *rows, int num_rows, int row_length);
+extern void find_demand_densities_scalar(double *density, const double *jobs, int num_jobs, double curr_time);
+extern kernel_struct *find_kernels(int instruction_set);
+extern kernel_struct *find_best_kernels(void);
+extern void initialize_kernels(void);
+extern kernel_struct *get_kernels(void);
+extern int select_kernels(int instruction_set);
+/*----------------------------------------------------------------------*/
+
+/*---------------------------BATCH FUNCTIONS---------------------------*/
+extern int run_batch(char *batch_file, char *summary_file, char *stats_file, int num_threads, options_struct *options);
+/*---------------------------------------------------------------------*/
+
+/*---------------------------TRACE FUNCTIONS---------------------------*/
+/*
+    Writes a statement to the trace of a core if its level is enabled. Statements above TRACE_MAX_LEVEL are removed by the compiler,
+    and statements above the runtime level of the trace cost one comparison, as their arguments are not evaluated.
+*/
+#define TRACE(trace_ptr, trace_level, ...)                                             \
+    do                                                                                 \
+    {                                                                                  \
+        if ((trace_level) <= TRACE_MAX_LEVEL && (trace_level) <= (trace_ptr)->level)   \
+            trace_write((trace_ptr), __VA_ARGS__);                                     \
+    } while (0)
+
+extern trace_struct *initialize_trace(FILE *output, int level, int mode);
+extern void trace_write(trace_struct *trace, const char *format, ...) __attribute__((format(printf, 2, 3)));
+extern void trace_job_list(trace_struct *trace, int level, job *job_list_head);
+extern void start_trace_drain(processor_struct *processor);
+extern void stop_trace_drain(processor_struct *processor);
+extern void free_trace(trace_struct *trace);
+extern int decode_trace(char *trace_file, FILE *output);
+/*---------------------------------------------------------------------*/
+
+/*---------------------------STATISTICS FUNCTIONS---------------------------*/
+extern histogram_struct *initialize_histograms(int num_histograms);
+extern void record_histogram(histogram_struct *histogram, int64_t value);
+extern void merge_histogram(histogram_struct *to, histogram_struct *from);
+extern double find_histogram_percentile(histogram_struct *histogram, double percentile);
+extern stats_struct *sum_core_stats(stats_struct *stats);
+extern void initialize_task_stats(stats_struct *stats, task_set_struct *task_set);
+extern void record_job_completion(stats_struct *stats, int core_no, job *completed_job, tick_t completion_time);
+extern int find_stats_format(char *file_name);
+extern void write_stats_header(FILE *output, int format);
+extern void write_stats_footer(FILE *output, int format);
+extern void write_stats_run(FILE *output, int format, int run, char *taskset, stats_struct *stats, int first);
+extern int write_stats_file(char *file_name, char *taskset, stats_struct *stats);
+/*---------------------------------------------------------------------*/
+
 /*---------------------------AUXILIARY FUNCTIONS---------------------------*/
-extern double gcd(double a, double b);
+extern tick_t gcd(tick_t a, tick_t b);
+extern tick_t lcm(tick_t a, tick_t b);
 extern double min(double a, double b);
 extern double max(double a, double b);
 extern int max_int(int a, int b);
 extern int min_int(int a, int b);
-extern int period_comparator(const void *p, const void *q);
-extern void print_task_list(task_set_struct *task_set);
-extern void print_job_list(int core_no, job *job_list_head);
-extern void print_total_utilisation(double total_utilisation[][MAX_CRITICALITY_LEVELS]);
+extern tick_t max_tick(tick_t a, tick_t b);
+extern tick_t min_tick(tick_t a, tick_t b);
+extern int task_order_comparator(const void *p, const void *q);
+extern int int_comparator(const void *p, const void *q);
+extern void print_task_list(FILE *output_file, task_set_struct *task_set);
+extern void print_job_list(FILE *output, job *job_list_head);
+extern void print_total_utilisation(FILE *output_file, double *total_utilisation, int total_levels);
 extern void print_processor(processor_struct *processor);
 extern int compare_jobs(job *A, job *B);
 extern double find_actual_execution_time(double exec_time, int task_crit_lvl, int core_crit_lvl);
-extern void set_virtual_deadlines(task_set_struct **task_set, int core_no, double x, int k);
-extern void reset_virtual_deadlines(task_set_struct **task_set, int core_no, int k);
-extern void set_execution_times(job* curr_job, double frequency);
-extern void reset_execution_times(job* curr_job, double frequency);
+extern void set_virtual_deadlines(task_set_struct **task_set, processor_struct *processor, int core_no, double x, int k);
+extern void reset_virtual_deadlines(task_set_struct **task_set, processor_struct *processor, int core_no, int k);
 extern void set_utilisation(task* task, int curr_crit_level, double exec_time);
 extern void reset_utilisation(task* task, int curr_crit_level);
 extern int check_all_cores(processor_struct *processor);
 extern int find_max_level(processor_struct *processor, task_set_struct *task_set);
-extern stats_struct* initialize_stats_struct();
+extern stats_struct* initialize_stats_struct(int total_cores);
+extern void free_stats_struct(stats_struct *stats);
 /*-------------------------------------------------------------------------*/
 
 #endif
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include "functions.h"
+
+/*
+    Function to set the default parameters of the generator: two criticality levels with half of the tasks at each, a utilisation of 0.5 at both levels,
+    and harmonic periods in [10, 1000] time units, which keep the hyperperiod short.
+*/
+void initialize_generator(generator_struct *generator)
+{
+    int i;
+
+    memset(generator, 0, sizeof(generator_struct));
+    generator->total_tasks = 10;
+    generator->total_levels = DEFAULT_CRITICALITY_LEVELS;
+    for (i = 0; i < GENERATOR_MAX_LEVELS; i++)
+    {
+        generator->target_util[i] = 0.50;
+        generator->criticality_mix[i] = 1.00;
+    }
+    generator->period_distribution = PERIOD_HARMONIC;
+    generator->min_period = 10.00;
+    generator->max_period = 1000.00;
+    generator->period_granularity = 1.00;
+    generator->max_task_util = 1.00;
+    generator->seed = 1;
+    generator->set_number = 0;
+}
+
+/*
+    Function to parse a comma separated list of numbers. Returns the number of values read, or -1 if the list is malformed or has more than max_values values.
+*/
+int parse_double_list(char *text, double *values, int max_values)
+{
+    int num_values = 0;
+    char *end;
+
+    while (*text != '\0')
+    {
+        if (num_values == max_values)
+            return -1;
+        values[num_values++] = strtod(text, &end);
+        if (end == text || (*end != ',' && *end != '\0'))
+            return -1;
+        text = (*end == ',') ? end + 1 : end;
+    }
+
+    return num_values;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the generator, the period distribution given on the command line}
+
+    Purpose of the function: Parses the period distribution of the generator, "log" or "harmonic", optionally followed by ":min:max" and, for log, ":granularity".
+
+    Postconditions:
+        Output: {1 if the distribution is valid, 0 otherwise}
+*/
+int parse_period_distribution(generator_struct *generator, char *text)
+{
+    double values[3];
+    char *bounds = strchr(text, ':');
+    size_t length = (bounds != NULL) ? (size_t)(bounds - text) : strlen(text);
+    int num_values = 0;
+
+    if (length == 3 && strncmp(text, "log", 3) == 0)
+        generator->period_distribution = PERIOD_LOG_UNIFORM;
+    else if (length == 8 && strncmp(text, "harmonic", 8) == 0)
+        generator->period_distribution = PERIOD_HARMONIC;
+    else
+        return 0;
+
+    if (bounds != NULL)
+    {
+        char list[64];
+        snprintf(list, sizeof(list), "%s", bounds + 1);
+        for (char *c = list; *c != '\0'; c++)
+        {
+            if (*c == ':')
+                *c = ',';
+        }
+        num_values = parse_double_list(list, values, 3);
+        if (num_values < 2)
+            return 0;
+        generator->min_period = values[0];
+        generator->max_period = values[1];
+        if (num_values == 3)
+            generator->period_granularity = values[2];
+    }
+
+    return generator->min_period > 0 && generator->max_period >= generator->min_period && generator->period_granularity > 0;
+}
+
+/*
+    Function to get the generator's uniform random number in [0, 1) for a draw about a task. The stream is keyed on the seed and the set number,
+    and is independent of the one of the execution time sampler even if both use the same seed.
+*/
+double generator_sample(generator_struct *generator, int task_number, int level, int draw)
+{
+    return uniform_sample(mix_bits(mix_bits(generator->seed) ^ generator->set_number), task_number, level, draw);
+}
+
+/*
+    Function to draw the criticality level of a task from the criticality mix of the generator.
+*/
+int draw_criticality_level(generator_struct *generator, int task_number)
+{
+    double total = 0.00, sample;
+    int level;
+
+    for (level = 0; level < generator->total_levels; level++)
+    {
+        total += generator->criticality_mix[level];
+    }
+
+    sample = generator_sample(generator, task_number, 0, 0) * total;
+    for (level = 0; level < generator->total_levels - 1; level++)
+    {
+        if (sample < generator->criticality_mix[level])
+            return level;
+        sample -= generator->criticality_mix[level];
+    }
+    return generator->total_levels - 1;
+}
+
+/*
+    Function to draw the period of a task from the period distribution of the generator. The period is in time units.
+*/
+double draw_period(generator_struct *generator, int task_number)
+{
+    double sample = generator_sample(generator, task_number, 0, 1);
+    double period;
+    int exponents;
+
+    if (generator->period_distribution == PERIOD_HARMONIC)
+    {
+        exponents = (int)floor(log2(generator->max_period / generator->min_period)) + 1;
+        return generator->min_period * (double)(1ULL << min_int((int)(sample * exponents), exponents - 1));
+    }
+
+    period = exp(log(generator->min_period) + sample * (log(generator->max_period) - log(generator->min_period)));
+    period = round(period / generator->period_granularity) * generator->period_granularity;
+    return fmax(period, generator->period_granularity);
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the generator, the criticality levels of the tasks, the utilisations of the tasks, the level}
+                The utilisations of the tasks are set up to the level below.
+
+    Purpose of the function: Draws the utilisations of the tasks at the given level with UUniFast-Discard. At level 0 the target utilisation is split over all the tasks.
+                             At a higher level only the tasks of at least that criticality get a share, and the share is added to their utilisation at the level below,
+                             so the WCETs do not decrease with the level and the tasks of at least the level sum to its target utilisation.
+                             If the target is below the utilisation already carried over from the level below, the level gets no increase.
+                             The draw is repeated while a task exceeds the maximum utilisation of the generator.
+
+    Postconditions:
+        Output: {1 if the utilisations were drawn, 0 if no draw kept every task under the maximum utilisation}
+*/
+int draw_level_utilisation(generator_struct *generator, int *criticality_lvl, double *util, int level)
+{
+    int total_levels = generator->total_levels;
+    double remaining, next, target = generator->target_util[level];
+    int attempt, i, num_tasks = 0, drawn;
+
+    for (i = 0; i < generator->total_tasks; i++)
+    {
+        if (criticality_lvl[i] >= level)
+        {
+            num_tasks++;
+            if (level > 0)
+                target -= util[i * total_levels + level - 1];
+        }
+    }
+    target = fmax(target, 0.00);
+
+    for (attempt = 0; attempt < GENERATOR_MAX_ATTEMPTS; attempt++)
+    {
+        remaining = target;
+        drawn = 0;
+        for (i = 0; i < generator->total_tasks; i++)
+        {
+            util[i * total_levels + level] = (level > 0) ? util[i * total_levels + level - 1] : 0.00;
+            if (criticality_lvl[i] < level)
+                continue;
+
+            //UUniFast: the share of the task is what is left after the sum of the remaining tasks is drawn.
+            drawn++;
+            next = (drawn < num_tasks) ? remaining * pow(generator_sample(generator, i, level, 2 + attempt), 1.0 / (num_tasks - drawn)) : 0.00;
+            util[i * total_levels + level] += remaining - next;
+            remaining = next;
+        }
+
+        for (i = 0; i < generator->total_tasks; i++)
+        {
+            if (criticality_lvl[i] >= level && util[i * total_levels + level] > generator->max_task_util)
+                break;
+        }
+        if (i == generator->total_tasks)
+            return 1;
+    }
+
+    return 0;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the generator}
+                0 < generator->total_levels <= GENERATOR_MAX_LEVELS
+
+    Purpose of the function: Generates a synthetic implicit-deadline taskset in memory. The criticality level and the period of each task are drawn from the criticality mix and the period distribution,
+                             and the utilisations of each level are drawn with UUniFast-Discard so that the tasks of at least the level sum to its target utilisation.
+                             The WCETs are the utilisations times the periods, rounded to a tick and at least one tick, so the utilisations of the taskset are recomputed from them.
+                             The tasks are unallocated, to be partitioned onto the cores, and their execution times are sampled with the seed of the generator
+                             until set_exec_time_source sets another source. GENERATOR_TRACE_JOBS execution times are written for each task if the taskset is written to a file.
+                             The tasks are numbered in the order of their periods, as get_taskset does for the tasksets read from files.
+
+    Postconditions:
+        Output: {Pointer to the taskset, NULL if the utilisations cannot be drawn}
+*/
+task_set_struct *generate_taskset(generator_struct *generator)
+{
+    int total_tasks = generator->total_tasks, total_levels = generator->total_levels;
+    task_set_struct *task_set;
+    int *criticality_lvl;
+    double *util;
+    int i, level;
+
+    criticality_lvl = (int *)malloc(sizeof(int) * max_int(total_tasks, 1));
+    util = (double *)malloc(sizeof(double) * max_int(total_tasks * total_levels, 1));
+    for (i = 0; i < total_tasks; i++)
+    {
+        criticality_lvl[i] = draw_criticality_level(generator, i);
+    }
+    for (level = 0; level < total_levels; level++)
+    {
+        if (!draw_level_utilisation(generator, criticality_lvl, util, level))
+        {
+            printf("ERROR: Cannot generate the utilisations of level %d with no task above %.2lf\n", level, generator->max_task_util);
+            free(criticality_lvl);
+            free(util);
+            return NULL;
+        }
+    }
+
+    task_set = (task_set_struct *)malloc(sizeof(task_set_struct));
+    allocate_task_tables(task_set, total_tasks, total_levels);
+    task_set->mapped_file = NULL;
+    task_set->mapped_size = 0;
+    task_set->exec_trace = NULL;
+
+    for (i = 0; i < total_tasks; i++)
+    {
+        task *curr_task = &task_set->task_list[i];
+
+        memset(curr_task, 0, sizeof(task));
+        task_set->period_table[i] = max_tick(UNITS_TO_TICKS(draw_period(generator, i)), 1);
+        curr_task->relative_deadline = task_set->period_table[i];
+        curr_task->virtual_deadline = task_set->period_table[i];
+        curr_task->criticality_lvl = criticality_lvl[i];
+        curr_task->core = -1;
+        curr_task->WCET = task_set->WCET_table + i * total_levels;
+        curr_task->util = task_set->util_table + i * total_levels;
+
+        for (level = 0; level < total_levels; level++)
+        {
+            curr_task->WCET[level] = max_tick((tick_t)llround(util[i * total_levels + level] * task_set->period_table[i]), 1);
+            if (level > 0)
+                curr_task->WCET[level] = max_tick(curr_task->WCET[level], curr_task->WCET[level - 1]);
+            curr_task->util[level] = (double)curr_task->WCET[level] / (double)task_set->period_table[i];
+        }
+
+        curr_task->exec_source.type = EXEC_TIME_SAMPLER;
+        curr_task->exec_source.num_exec_times = GENERATOR_TRACE_JOBS;
+        curr_task->exec_source.seed = generator->seed;
+        curr_task->exec_source.fraction = 1.00;
+    }
+
+    free(criticality_lvl);
+    free(util);
+
+    sort_taskset(task_set);
+
+    return task_set;
+}
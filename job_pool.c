@@ -0,0 +1,102 @@
+#include "functions.h"
+
+/*
+    Preconditions:
+        Input: {void}
+
+    Purpose of the function: Creates an empty job pool. The jobs are carved out of slabs of JOB_POOL_SLAB_SIZE jobs, which are allocated on demand and never returned to the system.
+
+    Postconditions:
+        Output: {Pointer to the job pool}
+                job_pool!=NULL
+*/
+job_pool_struct *initialize_job_pool()
+{
+    job_pool_struct *job_pool = (job_pool_struct *)malloc(sizeof(job_pool_struct));
+
+    job_pool->free_jobs = NULL;
+    job_pool->num_slabs = 0;
+    job_pool->max_slabs = 4;
+    job_pool->slabs = (job **)malloc(sizeof(job *) * job_pool->max_slabs);
+
+    return job_pool;
+}
+
+/*
+    Function to add a new slab to the pool and thread its jobs onto the freelist.
+*/
+void grow_job_pool(job_pool_struct *job_pool)
+{
+    job *slab;
+    int i;
+
+    if (job_pool->num_slabs == job_pool->max_slabs)
+    {
+        job_pool->max_slabs *= 2;
+        job_pool->slabs = (job **)realloc(job_pool->slabs, sizeof(job *) * job_pool->max_slabs);
+    }
+
+    slab = (job *)malloc(sizeof(job) * JOB_POOL_SLAB_SIZE);
+    job_pool->slabs[job_pool->num_slabs++] = slab;
+
+    for (i = JOB_POOL_SLAB_SIZE - 1; i >= 0; i--)
+    {
+        slab[i].next = job_pool->free_jobs;
+        job_pool->free_jobs = &slab[i];
+    }
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the job pool}
+                job_pool!=NULL
+
+    Purpose of the function: Takes a job from the freelist of the pool. A new slab is allocated only when the freelist is empty,
+                             so the memory used by the pool is bounded by the maximum number of jobs alive at the same time.
+
+    Postconditions:
+        Output: {Pointer to the job}
+                new_job!=NULL
+*/
+job *allocate_job(job_pool_struct *job_pool)
+{
+    job *new_job;
+
+    if (job_pool->free_jobs == NULL)
+        grow_job_pool(job_pool);
+
+    new_job = job_pool->free_jobs;
+    job_pool->free_jobs = new_job->next;
+
+    new_job->next = NULL;
+    new_job->child = NULL;
+    new_job->prev = NULL;
+
+    return new_job;
+}
+
+/*
+    Function to give a job back to the pool. The job can be released to the pool of any core, for example when a discarded job migrates and completes on another core.
+*/
+void release_job(job_pool_struct *job_pool, job *free_job)
+{
+    free_job->child = NULL;
+    free_job->prev = NULL;
+    free_job->next = job_pool->free_jobs;
+    job_pool->free_jobs = free_job;
+}
+
+/*
+    Function to free the job pool and all the jobs allocated from it.
+*/
+void free_job_pool(job_pool_struct *job_pool)
+{
+    int i;
+
+    for (i = 0; i < job_pool->num_slabs; i++)
+    {
+        free(job_pool->slabs[i]);
+    }
+    free(job_pool->slabs);
+    free(job_pool);
+}
@@ -0,0 +1,208 @@
+#include "functions.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KERNELS_X86
+#endif
+
+kernel_struct *selected_kernels = NULL;
+pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+/*
+    Function to add the rows of the table listed in rows to sum, one entry at a time.
+*/
+void add_rows_scalar(double *sum, const double *table, const int *rows, int num_rows, int row_length)
+{
+    const double *row;
+    int i, k;
+
+    for (i = 0; i < num_rows; i++)
+    {
+        row = table + (size_t)rows[i] * row_length;
+        for (k = 0; k < row_length; k++)
+        {
+            sum[k] += row[k];
+        }
+    }
+}
+
+/*
+    Function to find the demand density of each (deadline, remaining WCET) pair of jobs, one job at a time.
+*/
+void find_demand_densities_scalar(double *density, const double *jobs, int num_jobs, double curr_time)
+{
+    int i;
+
+    for (i = 0; i < num_jobs; i++)
+    {
+        density[i] = (jobs[2 * i] > curr_time) ? jobs[2 * i + 1] / (jobs[2 * i] - curr_time) : 0;
+    }
+}
+
+#ifdef KERNELS_X86
+/*
+    Function to add the rows of the table listed in rows to sum, two levels at a time.
+*/
+__attribute__((target("sse2"))) void add_rows_sse2(double *sum, const double *table, const int *rows, int num_rows, int row_length)
+{
+    const double *row;
+    int i, k;
+
+    for (i = 0; i < num_rows; i++)
+    {
+        row = table + (size_t)rows[i] * row_length;
+        for (k = 0; k + 2 <= row_length; k += 2)
+        {
+            _mm_storeu_pd(sum + k, _mm_add_pd(_mm_loadu_pd(sum + k), _mm_loadu_pd(row + k)));
+        }
+        for (; k < row_length; k++)
+        {
+            sum[k] += row[k];
+        }
+    }
+}
+
+/*
+    Function to find the demand densities two jobs at a time. The pairs are split into a vector of deadlines and a vector of WCETs,
+    and the densities of the jobs whose deadline is not after the current time are masked to 0.
+*/
+__attribute__((target("sse2"))) void find_demand_densities_sse2(double *density, const double *jobs, int num_jobs, double curr_time)
+{
+    __m128d time = _mm_set1_pd(curr_time), first, second, deadline, WCET;
+    int i;
+
+    for (i = 0; i + 2 <= num_jobs; i += 2)
+    {
+        first = _mm_loadu_pd(jobs + 2 * i);
+        second = _mm_loadu_pd(jobs + 2 * i + 2);
+        deadline = _mm_unpacklo_pd(first, second);
+        WCET = _mm_unpackhi_pd(first, second);
+        _mm_storeu_pd(density + i, _mm_and_pd(_mm_cmpgt_pd(deadline, time), _mm_div_pd(WCET, _mm_sub_pd(deadline, time))));
+    }
+    find_demand_densities_scalar(density + i, jobs + 2 * i, num_jobs - i, curr_time);
+}
+
+/*
+    Function to add the rows of the table listed in rows to sum, four levels at a time.
+*/
+__attribute__((target("avx2"))) void add_rows_avx2(double *sum, const double *table, const int *rows, int num_rows, int row_length)
+{
+    const double *row;
+    int i, k;
+
+    for (i = 0; i < num_rows; i++)
+    {
+        row = table + (size_t)rows[i] * row_length;
+        for (k = 0; k + 4 <= row_length; k += 4)
+        {
+            _mm256_storeu_pd(sum + k, _mm256_add_pd(_mm256_loadu_pd(sum + k), _mm256_loadu_pd(row + k)));
+        }
+        for (; k + 2 <= row_length; k += 2)
+        {
+            _mm_storeu_pd(sum + k, _mm_add_pd(_mm_loadu_pd(sum + k), _mm_loadu_pd(row + k)));
+        }
+        for (; k < row_length; k++)
+        {
+            sum[k] += row[k];
+        }
+    }
+}
+
+/*
+    Function to find the demand densities four jobs at a time. The unpacks give the deadlines and the WCETs of the jobs in the order 0, 2, 1, 3,
+    which the permutation puts back in order. The last jobs are done here too, as calling the SSE2 kernel with the upper halves of the registers in use
+    costs a transition between the two instruction sets on some processors.
+*/
+__attribute__((target("avx2"))) void find_demand_densities_avx2(double *density, const double *jobs, int num_jobs, double curr_time)
+{
+    __m256d time = _mm256_set1_pd(curr_time), first, second, deadline, WCET;
+    int i;
+
+    for (i = 0; i + 4 <= num_jobs; i += 4)
+    {
+        first = _mm256_loadu_pd(jobs + 2 * i);
+        second = _mm256_loadu_pd(jobs + 2 * i + 4);
+        deadline = _mm256_permute4x64_pd(_mm256_unpacklo_pd(first, second), 0xD8);
+        WCET = _mm256_permute4x64_pd(_mm256_unpackhi_pd(first, second), 0xD8);
+        _mm256_storeu_pd(density + i, _mm256_and_pd(_mm256_cmp_pd(deadline, time, _CMP_GT_OQ), _mm256_div_pd(WCET, _mm256_sub_pd(deadline, time))));
+    }
+    for (; i < num_jobs; i++)
+    {
+        density[i] = (jobs[2 * i] > curr_time) ? jobs[2 * i + 1] / (jobs[2 * i] - curr_time) : 0;
+    }
+}
+#endif
+
+kernel_struct kernel_sets[KERNEL_SETS] = {
+    {"scalar", add_rows_scalar, find_demand_densities_scalar},
+#ifdef KERNELS_X86
+    {"sse2", add_rows_sse2, find_demand_densities_sse2},
+    {"avx2", add_rows_avx2, find_demand_densities_avx2},
+#endif
+};
+
+/*
+    Function to find the kernels of an instruction set, or NULL if the processor does not support it.
+*/
+kernel_struct *find_kernels(int instruction_set)
+{
+    if (instruction_set < 0 || instruction_set >= KERNEL_SETS || kernel_sets[instruction_set].name == NULL)
+        return NULL;
+
+#ifdef KERNELS_X86
+    __builtin_cpu_init();
+    if (instruction_set == KERNELS_SSE2 && !__builtin_cpu_supports("sse2"))
+        return NULL;
+    if (instruction_set == KERNELS_AVX2 && !__builtin_cpu_supports("avx2"))
+        return NULL;
+#endif
+
+    return &kernel_sets[instruction_set];
+}
+
+/*
+    Function to find the kernels of the best instruction set the processor supports. The scalar kernels are always supported.
+*/
+kernel_struct *find_best_kernels(void)
+{
+    kernel_struct *best = NULL;
+    int instruction_set;
+
+    for (instruction_set = KERNEL_SETS - 1; best == NULL; instruction_set--)
+    {
+        best = find_kernels(instruction_set);
+    }
+    return best;
+}
+
+/*
+    Function to select the kernels of the best instruction set the processor supports.
+*/
+void initialize_kernels(void)
+{
+    selected_kernels = find_best_kernels();
+}
+
+/*
+    Function to find the kernels in use. They are selected on the first call, once for all the threads.
+*/
+kernel_struct *get_kernels(void)
+{
+    pthread_once(&kernels_once, initialize_kernels);
+    return selected_kernels;
+}
+
+/*
+    Function to use the kernels of an instruction set instead of the selected ones, as the benchmark does to compare them, or the best ones again if it is negative.
+    It must not be called while a simulation is running. Returns 0 if the processor does not support the instruction set.
+*/
+int select_kernels(int instruction_set)
+{
+    kernel_struct *selected = (instruction_set < 0) ? find_best_kernels() : find_kernels(instruction_set);
+
+    if (selected == NULL)
+        return 0;
+    pthread_once(&kernels_once, initialize_kernels);
+    selected_kernels = selected;
+    return 1;
+}
@@ -0,0 +1,265 @@
+#include "functions.h"
+
+/*
+    Preconditions:
+        Input: {pointer to the parallel simulation, the task number, the criticality level of the core of the task}
+
+    Purpose of the function: Finds the release time of the first job of the task, from its next release on, whose execution time exceeds the WCET of the task at the level.
+                             The execution times are looked ahead PARALLEL_LOOKAHEAD_JOBS jobs at a time, and the job found is kept until the task releases it.
+                             If no job overruns within the lookahead, the job at which it stopped is taken to overrun.
+                             The execution times of a text trace are read in windows that only move forward, so with a trace the next job is taken to overrun.
+
+    Postconditions:
+        Output: {The release time of the job}
+*/
+tick_t find_next_overrun_release(parallel_struct *parallel, int task_number, int crit_level)
+{
+    task_set_struct *task_set = parallel->task_set;
+    task *curr_task = &task_set->task_list[task_number];
+    int job_number = task_set->job_number_table[task_number], last_job;
+
+    if (parallel->overrun_level[task_number] != crit_level || parallel->overrun_job[task_number] < job_number)
+    {
+        last_job = job_number;
+        if (curr_task->exec_source.type != EXEC_TIME_TRACE)
+        {
+            while (last_job < job_number + PARALLEL_LOOKAHEAD_JOBS && find_execution_time(curr_task, last_job) <= curr_task->WCET[crit_level])
+                last_job++;
+        }
+        parallel->overrun_job[task_number] = last_job;
+        parallel->overrun_level[task_number] = crit_level;
+    }
+
+    return task_set->phase_table[task_number] + task_set->period_table[task_number] * parallel->overrun_job[task_number];
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the parallel simulation, the core number}
+                The core has taken its decision points up to its current time.
+
+    Purpose of the function: Finds the earliest time at which the core can change its criticality level, as long as no other core changes it first.
+                             A job overruns once it has executed the cycles of its WCET counter, and a core executes at most one cycle per tick, so:
+                             The current job overruns at the WCET counter of the core, unless a job arrives before. The frequency of the core can then rise,
+                             and the job overruns at the earliest after the cycles it has left at the arrival.
+                             Any other job of the ready queue overruns at the earliest after its WCET counter from the current time.
+                             The jobs taken back from the discarded queue are dropped at the end of their budget, so they are not considered.
+                             A job not released yet overruns at the earliest after the WCET of its task at the level of the core from its release.
+                             Only the jobs whose execution time exceeds their WCET counter and the tasks of at least the level of the core are considered,
+                             and a core at the highest level never changes it.
+
+    Postconditions:
+        Output: {The synchronisation time of the core, TICK_MAX if it cannot change its criticality level}
+*/
+tick_t find_core_sync_time(parallel_struct *parallel, int core_no)
+{
+    task *task_list = parallel->task_set->task_list;
+    core_struct *core = &parallel->processor->cores[core_no];
+    tick_t sync_time = TICK_MAX, next_arrival;
+    job *curr;
+    int i, task_number;
+
+    if (core->crit_level >= parallel->processor->total_levels - 1)
+        return TICK_MAX;
+
+    for (curr = core->ready_queue->job_list_head; curr != NULL; curr = next_job_in_queue(curr))
+    {
+        //A reclaimed job is dropped at the end of its budget instead.
+        if (curr->rem_exec_time <= curr->WCET_counter || curr->reclaimed_exec_time > 0)
+            continue;
+
+        if (curr == core->curr_exec_job)
+        {
+            next_arrival = find_earliest_arrival_job(core);
+            if (next_arrival < core->WCET_counter)
+                sync_time = min_tick(sync_time, next_arrival + curr->WCET_counter - find_executed_cycles(next_arrival - core->total_time, core->frequency));
+            else
+                sync_time = min_tick(sync_time, core->WCET_counter);
+        }
+        else
+        {
+            sync_time = min_tick(sync_time, core->total_time + curr->WCET_counter);
+        }
+    }
+
+    for (i = core->level_index[core->crit_level]; i < core->level_index[parallel->processor->total_levels]; i++)
+    {
+        task_number = core->task_index[i];
+        sync_time = min_tick(sync_time, find_next_overrun_release(parallel, task_number, core->crit_level) + task_list[task_number].WCET[core->crit_level]);
+    }
+
+    return sync_time;
+}
+
+/*
+    Function to update the synchronisation time of the core after a decision point taken outside of an epoch.
+*/
+void update_core_sync_time(parallel_struct *parallel, int core_no)
+{
+    parallel->sync_time[core_no] = find_core_sync_time(parallel, core_no);
+}
+
+/*
+    Function to find the synchronisation time of the processor, that is the earliest time at which any core can change its criticality level.
+*/
+tick_t find_parallel_sync_time(parallel_struct *parallel)
+{
+    tick_t sync_time = TICK_MAX;
+    int core_no;
+
+    for (core_no = 0; core_no < parallel->processor->total_cores; core_no++)
+    {
+        sync_time = min_tick(sync_time, parallel->sync_time[core_no]);
+    }
+
+    return sync_time;
+}
+
+/*
+    Function to take the decision points of the core before the end of the epoch, and then find its synchronisation time for the next epoch.
+*/
+void run_core_epoch(parallel_struct *parallel, int core_no)
+{
+    decision_struct decision;
+
+    while (1)
+    {
+        decision = find_core_decision_point(parallel->processor, core_no);
+        if (decision.decision_time >= parallel->epoch_end)
+            break;
+        if (!process_decision_point(parallel->task_set, parallel->processor, decision))
+        {
+            parallel->missed[core_no] = 1;
+            return;
+        }
+    }
+
+    parallel->sync_time[core_no] = find_core_sync_time(parallel, core_no);
+}
+
+/*
+    Function run by each thread of the parallel simulation. In each epoch the thread takes the decision points of its cores, until the simulation is over.
+*/
+void *parallel_worker(void *argument)
+{
+    parallel_worker_struct *worker = (parallel_worker_struct *)argument;
+    parallel_struct *parallel = worker->parallel;
+    int core_no;
+
+    while (1)
+    {
+        pthread_barrier_wait(&parallel->start);
+        if (parallel->done)
+            break;
+
+        for (core_no = worker->thread_number; core_no < parallel->processor->total_cores; core_no += parallel->num_threads)
+        {
+            run_core_epoch(parallel, core_no);
+        }
+        pthread_barrier_wait(&parallel->end);
+    }
+
+    return NULL;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to taskset, pointer to processor}
+                The event calendars of the processor are built.
+
+    Purpose of the function: Starts min(processor->threads, processor->total_cores) threads for the cores of the processor, which wait for the first epoch,
+                             and finds the synchronisation time of each core.
+
+    Postconditions:
+        Output: {Pointer to the parallel simulation}
+*/
+parallel_struct *start_parallel_schedule(task_set_struct *task_set, processor_struct *processor)
+{
+    parallel_struct *parallel = (parallel_struct *)malloc(sizeof(parallel_struct));
+    int i;
+
+    parallel->task_set = task_set;
+    parallel->processor = processor;
+    parallel->num_threads = min_int(processor->threads, processor->total_cores);
+    parallel->epoch_end = 0;
+    parallel->done = 0;
+    parallel->sync_time = (tick_t *)malloc(sizeof(tick_t) * processor->total_cores);
+    parallel->missed = (int *)calloc(processor->total_cores, sizeof(int));
+    parallel->overrun_job = (int *)malloc(sizeof(int) * max_int(task_set->total_tasks, 1));
+    parallel->overrun_level = (int *)malloc(sizeof(int) * max_int(task_set->total_tasks, 1));
+    for (i = 0; i < task_set->total_tasks; i++)
+    {
+        parallel->overrun_level[i] = -1;
+    }
+    for (i = 0; i < processor->total_cores; i++)
+    {
+        update_core_sync_time(parallel, i);
+    }
+
+    //The scheduler waits at the barriers with the threads.
+    pthread_barrier_init(&parallel->start, NULL, parallel->num_threads + 1);
+    pthread_barrier_init(&parallel->end, NULL, parallel->num_threads + 1);
+    parallel->workers = (parallel_worker_struct *)malloc(sizeof(parallel_worker_struct) * parallel->num_threads);
+    for (i = 0; i < parallel->num_threads; i++)
+    {
+        parallel->workers[i].parallel = parallel;
+        parallel->workers[i].thread_number = i;
+        pthread_create(&parallel->workers[i].thread, NULL, parallel_worker, &parallel->workers[i]);
+    }
+
+    return parallel;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the parallel simulation, the end of the epoch}
+                epoch_end is at most the synchronisation time of the processor, and every decision point before it is of an arrival, a completion or a timer expiry.
+
+    Purpose of the function: Runs an epoch of the parallel simulation. The threads take the decision points of their cores before the end of the epoch.
+                             The cores do not affect each other in between, so each core takes the same decisions as if the decision points of the processor were taken one at a time.
+                             The entries of the cores in the event calendar of the processor are then updated, and the cores have new synchronisation times.
+                             Unless the simulation continues on a miss, a core that misses a deadline stops there, and the other cores stop at the end of the epoch.
+
+    Postconditions:
+        Output: {0 if a core missed a deadline and the simulation ends, 1 otherwise}
+*/
+int run_parallel_epoch(parallel_struct *parallel, tick_t epoch_end)
+{
+    int core_no, missed = 0;
+
+    parallel->epoch_end = epoch_end;
+    pthread_barrier_wait(&parallel->start);
+    pthread_barrier_wait(&parallel->end);
+
+    for (core_no = 0; core_no < parallel->processor->total_cores; core_no++)
+    {
+        missed |= parallel->missed[core_no];
+        update_core_decision_point(parallel->processor, core_no);
+    }
+
+    return !missed;
+}
+
+/*
+    Function to stop the threads of the parallel simulation and free it.
+*/
+void stop_parallel_schedule(parallel_struct *parallel)
+{
+    int i;
+
+    parallel->done = 1;
+    pthread_barrier_wait(&parallel->start);
+    for (i = 0; i < parallel->num_threads; i++)
+    {
+        pthread_join(parallel->workers[i].thread, NULL);
+    }
+
+    pthread_barrier_destroy(&parallel->start);
+    pthread_barrier_destroy(&parallel->end);
+    free(parallel->workers);
+    free(parallel->sync_time);
+    free(parallel->missed);
+    free(parallel->overrun_job);
+    free(parallel->overrun_level);
+    free(parallel);
+}
@@ -0,0 +1,137 @@
+#include "functions.h"
+
+/*
+    Function to compare the future jobs of the procrastination interval on their deadlines.
+*/
+int la_edf_comparator(const void *A, const void *B)
+{
+    const la_edf_struct *a = (const la_edf_struct *)A;
+    const la_edf_struct *b = (const la_edf_struct *)B;
+    return (a->deadline > b->deadline) - (a->deadline < b->deadline);
+}
+
+/*
+    Preconditions:
+        Input: {current time, pointer to taskset, pointer to processor, the current crit level, the core number}
+                The ready queue of the core is empty, so all the demand of the core comes from the jobs not released yet.
+
+    Purpose of the function: Finds the longest interval for which the core can stay asleep from the current time and still meet the deadline of every future job.
+                             The interval is the minimum over the future deadlines d of d - curr_time - dbf(d), where dbf(d) is the demand of the jobs due by d.
+                             The demand of a job is the WCET at the criticality level of its task and its deadline is the virtual deadline,
+                             so the jobs meet their deadlines even if the core changes its criticality level after waking up.
+                             The deadlines are collected up to the point after which the slack can only grow, which is
+                             (first deadline - curr_time + sum of WCETs) / (1 - U) with U the utilisation of the tasks at their criticality levels,
+                             and at most one hyperperiod of the tasks of the core after the last of their next deadlines, as the slack then repeats with an increase of (1 - U) * hyperperiod.
+
+    Postconditions:
+        Output: {The procrastination interval in ticks, 0 if the core cannot sleep}
+*/
+tick_t find_procrastination_interval(tick_t curr_time, task_set_struct *task_set, processor_struct *processor, int curr_crit_level, int core_no)
+{
+    task *task_list = task_set->task_list;
+    tick_t *period = task_set->period_table, *release = task_set->release_table;
+    core_struct *core = &processor->cores[core_no];
+    la_edf_struct *jobs;
+    double util = 0.00;
+    tick_t total_WCET = 0, first_deadline = TICK_MAX, last_deadline = 0, hyperperiod = 1, horizon, deadline, demand, interval;
+    int i, j, num_jobs = 0, capacity = 16;
+    int first_task = core->level_index[curr_crit_level], last_task = core->level_index[processor->total_levels];
+
+    //Only the tasks of the core of at least the current level release jobs.
+    for (j = first_task; j < last_task; j++)
+    {
+        i = core->task_index[j];
+        util += (double)task_list[i].WCET[task_list[i].criticality_lvl] / (double)period[i];
+        total_WCET += task_list[i].WCET[task_list[i].criticality_lvl];
+        deadline = release[i] + task_list[i].virtual_deadline;
+        first_deadline = min_tick(first_deadline, deadline);
+        last_deadline = max_tick(last_deadline, deadline);
+        if (hyperperiod > 0)
+            hyperperiod = lcm(hyperperiod, period[i]);
+    }
+
+    if (first_deadline == TICK_MAX)
+        return TICK_MAX;
+    if (util >= 1.00)
+        return 0;
+
+    horizon = TICK_MAX;
+    if ((first_deadline - curr_time + total_WCET) / (1.00 - util) < (double)(TICK_MAX / 2))
+        horizon = curr_time + (tick_t)ceil((first_deadline - curr_time + total_WCET) / (1.00 - util));
+    if (hyperperiod > 0 && last_deadline <= TICK_MAX - hyperperiod)
+        horizon = min_tick(horizon, last_deadline + hyperperiod);
+
+    //Collect the deadlines of the future jobs up to the horizon and sort them, so that the demand bound at each deadline is a prefix sum.
+    jobs = (la_edf_struct *)malloc(sizeof(la_edf_struct) * capacity);
+    for (j = first_task; j < last_task; j++)
+    {
+        i = core->task_index[j];
+        for (deadline = release[i] + task_list[i].virtual_deadline; deadline <= horizon; deadline += period[i])
+        {
+            if (num_jobs == capacity)
+            {
+                capacity *= 2;
+                jobs = (la_edf_struct *)realloc(jobs, sizeof(la_edf_struct) * capacity);
+            }
+            jobs[num_jobs].task_number = i;
+            jobs[num_jobs].deadline = deadline;
+            jobs[num_jobs].exec_time = task_list[i].WCET[task_list[i].criticality_lvl];
+            num_jobs++;
+        }
+    }
+    qsort((void *)jobs, num_jobs, sizeof(la_edf_struct), la_edf_comparator);
+
+    interval = TICK_MAX;
+    demand = 0;
+    for (i = 0; i < num_jobs; i++)
+    {
+        demand += jobs[i].exec_time;
+        if (i + 1 < num_jobs && jobs[i + 1].deadline == jobs[i].deadline)
+            continue;
+        interval = min_tick(interval, jobs[i].deadline - curr_time - demand);
+    }
+    free(jobs);
+
+    return max_tick(interval, 0);
+}
+
+/*
+    Preconditions:
+        Input: {pointer to taskset, pointer to processor, the core number}
+                The time of the core is the current decision time.
+
+    Purpose of the function: Shuts an idle core down if it can sleep for at least the shutdown threshold of the processor.
+                             The core sleeps for the procrastination interval, or until the next arrival if that is later, as no job is deferred before it.
+                             The arrivals while the core is asleep are not decision points. They are released together when the timer expires.
+
+    Postconditions:
+        Output: {void}
+        Result: The core is either left active or is in the SHUTDOWN state with its timer set.
+*/
+void update_core_shutdown(task_set_struct *task_set, processor_struct *processor, int core_no)
+{
+    core_struct *core = &processor->cores[core_no];
+    tick_t interval, next_arrival;
+
+    if (processor->shutdown_threshold < 0 || core->state != ACTIVE || core->curr_exec_job != NULL || core->ready_queue->num_jobs != 0)
+        return;
+
+    interval = find_procrastination_interval(core->total_time, task_set, processor, core->crit_level, core_no);
+    next_arrival = find_earliest_arrival_job(core);
+    if (next_arrival != TICK_MAX)
+        interval = max_tick(interval, next_arrival - core->total_time);
+
+    if (interval < processor->shutdown_threshold)
+    {
+        TRACE(core->trace, TRACE_JOBS, "Procrastination interval: %.5lf\n", TICKS_TO_UNITS(interval));
+        return;
+    }
+
+    //A core without jobs left to release sleeps until the end of the simulation.
+    core->state = SHUTDOWN;
+    core->next_invocation_time = (interval == TICK_MAX) ? TICK_MAX : core->total_time + interval;
+    if (interval == TICK_MAX)
+        TRACE(core->trace, TRACE_DECISIONS, "Core shut down\n");
+    else
+        TRACE(core->trace, TRACE_DECISIONS, "Core shut down until %.5lf\n", TICKS_TO_UNITS(core->next_invocation_time));
+}
@@ -12,27 +12,25 @@
     Postconditions:
         Output: {null}
 */
-void insert_job_in_discarded_queue(processor_struct **processor, job *new_job, task *task_list, int core_no)
+void insert_job_in_discarded_list(job_queue_struct *discarded_queue, job *new_job, task *task_list)
 {
     job *temp;
 
-    job_queue_struct **discarded_queue = (&(*processor)->cores[core_no].local_discarded_queue);
-
-    if ((*discarded_queue)->num_jobs == 0)
+    if (discarded_queue->num_jobs == 0)
     {
-        (*discarded_queue)->job_list_head = new_job;
-        (*discarded_queue)->num_jobs++;
+        discarded_queue->job_list_head = new_job;
+        discarded_queue->num_jobs++;
     }
     else
     {
-        if (task_list[new_job->task_number].criticality_lvl > task_list[(*discarded_queue)->job_list_head->task_number].criticality_lvl || (task_list[new_job->task_number].criticality_lvl == task_list[(*discarded_queue)->job_list_head->task_number].criticality_lvl && new_job->absolute_deadline < (*discarded_queue)->job_list_head->absolute_deadline))
+        if (task_list[new_job->task_number].criticality_lvl > task_list[discarded_queue->job_list_head->task_number].criticality_lvl || (task_list[new_job->task_number].criticality_lvl == task_list[discarded_queue->job_list_head->task_number].criticality_lvl && new_job->absolute_deadline < discarded_queue->job_list_head->absolute_deadline))
         {
-            new_job->next = (*discarded_queue)->job_list_head;
-            (*discarded_queue)->job_list_head = new_job;
+            new_job->next = discarded_queue->job_list_head;
+            discarded_queue->job_list_head = new_job;
         }
         else
         {
-            temp = (*discarded_queue)->job_list_head;
+            temp = discarded_queue->job_list_head;
 
             while (temp && temp->next && (task_list[temp->next->task_number].criticality_lvl > task_list[new_job->task_number].criticality_lvl || (task_list[temp->next->task_number].criticality_lvl == task_list[new_job->task_number].criticality_lvl && temp->next->absolute_deadline <= new_job->absolute_deadline)))
             {
@@ -41,58 +39,158 @@ void insert_job_in_discarded_queue(processor_struct **processor, job *new_job, t
             new_job->next = temp->next;
             temp->next = new_job;
         }
-        (*discarded_queue)->num_jobs++;
+        discarded_queue->num_jobs++;
     }
 }
 
-void remove_jobs_from_discarded_queue(processor_struct **processor, double curr_time)
+/*
+    Function to insert a job discarded by a core in the discarded queue of the core, or in the discarded pool of the processor in semi-partitioned mode.
+*/
+void insert_job_in_discarded_queue(processor_struct **processor, job *new_job, task *task_list, int core_no)
 {
-    for(int i = 0; i < NUM_CORES; i++){
-
-        job_queue_struct **discarded_queue = &(*processor)->cores[i].local_discarded_queue;
+    if ((*processor)->migration == MIGRATION_SEMI_PARTITIONED)
+    {
+        pthread_mutex_lock(&(*processor)->discarded_lock);
+        insert_job_in_discarded_list((*processor)->discarded_pool, new_job, task_list);
+        pthread_mutex_unlock(&(*processor)->discarded_lock);
+    }
+    else
+    {
+        insert_job_in_discarded_list((*processor)->cores[core_no].local_discarded_queue, new_job, task_list);
+    }
+}
 
-        job *free_job, *prev, *curr, *dummy_node;
-        dummy_node = malloc(sizeof(job));
-        dummy_node->next = (*discarded_queue)->job_list_head;
-        dummy_node->task_number = -1;
-        dummy_node->job_number = -1;
+/*
+    Function to give the jobs of a discarded queue whose deadline has passed back to the given job pool.
+*/
+void remove_expired_jobs(job_queue_struct *discarded_queue, job_pool_struct *job_pool, tick_t curr_time)
+{
+    job *free_job, **link;
 
-        prev = dummy_node;
-        curr = (*discarded_queue)->job_list_head;
+    link = &discarded_queue->job_list_head;
 
-        while(curr != NULL)
+    while(*link != NULL)
+    {
+        if((*link)->absolute_deadline <= curr_time)
         {
-            // printf("Prev: %d,%d. Curr: %d,%d\n", prev->task_number, prev->job_number, curr->task_number, curr->job_number);
-            if(curr->absolute_deadline <= curr_time)
-            {
-                free_job = curr;
-                prev->next = curr->next;
-                curr = curr->next;
-                free_job->next = NULL;
-                (*discarded_queue)->num_jobs--;
-                // free(free_job);
-            }
-            else
-            {
-                prev = curr;
-                curr = curr->next;
-            }
+            free_job = *link;
+            *link = free_job->next;
+            discarded_queue->num_jobs--;
+            release_job(job_pool, free_job);
         }
+        else
+        {
+            link = &(*link)->next;
+        }
+    }
+}
+
+/*
+    Function to remove the jobs of the discarded queue of the core, and of the discarded pool in semi-partitioned mode, whose deadline has passed.
+    A core only takes discarded jobs after removing the expired ones, so each core removes them from its own queue and the cores can do it on their own threads.
+    Any pool can take a job back, so the expired jobs of the discarded pool go to the pool of the core.
+*/
+void remove_jobs_from_discarded_queue(processor_struct *processor, int core_no, tick_t curr_time)
+{
+    remove_expired_jobs(processor->cores[core_no].local_discarded_queue, processor->cores[core_no].job_pool, curr_time);
 
-        (*discarded_queue)->job_list_head = dummy_node->next;
-        dummy_node->next = NULL;
-        free(dummy_node);
+    if (processor->migration == MIGRATION_SEMI_PARTITIONED)
+    {
+        pthread_mutex_lock(&processor->discarded_lock);
+        remove_expired_jobs(processor->discarded_pool, processor->cores[core_no].job_pool, curr_time);
+        pthread_mutex_unlock(&processor->discarded_lock);
     }
     return;
 }
 
+/*
+    A comparator to check whether job A has to be served before job B in the ready queue.
+    Jobs are ordered on their absolute deadlines. Jobs with equal deadlines are served in the order of their insertion.
+*/
+int job_precedes(job *A, job *B)
+{
+    if (A->absolute_deadline != B->absolute_deadline)
+        return A->absolute_deadline < B->absolute_deadline;
+    return A->queue_order < B->queue_order;
+}
+
+/*
+    Function to merge two pairing heaps. The root with the later deadline becomes the leftmost child of the other root.
+*/
+job *merge_job_heaps(job *A, job *B)
+{
+    job *temp;
+
+    if (A == NULL)
+        return B;
+    if (B == NULL)
+        return A;
+
+    if (job_precedes(B, A))
+    {
+        temp = A;
+        A = B;
+        B = temp;
+    }
+
+    B->prev = A;
+    B->next = A->child;
+    if (A->child != NULL)
+        A->child->prev = B;
+    A->child = B;
+    A->next = NULL;
+    A->prev = NULL;
+
+    return A;
+}
+
+/*
+    Function to merge a list of sibling heaps (linked through next) into a single heap.
+    The siblings are merged in pairs from left to right, and then the pairs are merged from right to left.
+*/
+job *merge_job_pairs(job *first)
+{
+    job *A, *B, *rest, *pairs = NULL, *merged = NULL;
+
+    while (first != NULL)
+    {
+        A = first;
+        B = A->next;
+        rest = (B != NULL) ? B->next : NULL;
+
+        A->next = NULL;
+        A->prev = NULL;
+        if (B != NULL)
+        {
+            B->next = NULL;
+            B->prev = NULL;
+        }
+
+        A = merge_job_heaps(A, B);
+        A->next = pairs;
+        pairs = A;
+        first = rest;
+    }
+
+    while (pairs != NULL)
+    {
+        A = pairs;
+        pairs = A->next;
+        A->next = NULL;
+        merged = merge_job_heaps(merged, A);
+    }
+
+    return merged;
+}
+
 /*
     Preconditions:
         Input: {pointer to ready queue (passed by pointer), pointer to job to be inserted}
                 (*ready_queue)!=NULL
                 new_job!=NULL
 
-    Purpose of the function: This function enters a new job in the ready queue in the appropriate location. The ready queue is sorted according to the deadlines.
+    Purpose of the function: This function enters a new job in the ready queue. The ready queue is a pairing heap ordered on the deadlines, so the insertion takes O(1) time.
+                             The job is also inserted in the slack cache of the queue, if it is built.
                             
     Postconditions: 
         Output: {void}
@@ -100,37 +198,67 @@ void remove_jobs_from_discarded_queue(processor_struct **processor, double curr_
 */
 void insert_job_in_ready_queue(job_queue_struct **ready_queue, job *new_job)
 {
-    job *temp;
+    new_job->next = NULL;
+    new_job->prev = NULL;
+    new_job->child = NULL;
+    new_job->queue_order = (*ready_queue)->num_inserted++;
 
-    if ((*ready_queue)->num_jobs == 0)
-    {
-        (*ready_queue)->job_list_head = new_job;
-        (*ready_queue)->num_jobs = 1;
-    }
-    else
-    {
-        if (new_job->absolute_deadline < (*ready_queue)->job_list_head->absolute_deadline)
-        {
-            new_job->next = (*ready_queue)->job_list_head;
-            (*ready_queue)->job_list_head = new_job;
-        }
-        else
-        {
+    (*ready_queue)->job_list_head = merge_job_heaps((*ready_queue)->job_list_head, new_job);
+    (*ready_queue)->num_jobs++;
+    insert_slack_job((*ready_queue)->slack_cache, new_job);
 
-            temp = (*ready_queue)->job_list_head;
+    return;
+}
 
-            while (temp->next != NULL && temp->next->absolute_deadline <= new_job->absolute_deadline)
-            {
-                temp = temp->next;
-            }
-            new_job->next = temp->next;
-            temp->next = new_job;
-        }
+/*
+    Preconditions:
+        Input: {pointer to ready queue (passed by pointer)}
+
+    Purpose of the function: This function removes the job with the earliest deadline from the ready queue. It takes O(log n) amortized time.
+
+    Postconditions:
+        Output: {The removed job, NULL if the ready queue is empty}
+*/
+job *remove_min_job_from_ready_queue(job_queue_struct **ready_queue)
+{
+    job *min_job = (*ready_queue)->job_list_head;
 
-        (*ready_queue)->num_jobs++;
+    if (min_job == NULL)
+        return NULL;
+
+    (*ready_queue)->job_list_head = merge_job_pairs(min_job->child);
+    (*ready_queue)->num_jobs--;
+    remove_slack_job((*ready_queue)->slack_cache, min_job);
+
+    min_job->child = NULL;
+    min_job->next = NULL;
+    min_job->prev = NULL;
+
+    return min_job;
+}
+
+/*
+    Function to iterate over all the jobs of a queue, starting from job_list_head. The jobs of the ready queue are visited in heap order (not sorted on deadline).
+    It works for the discarded queue too, where the jobs have no children and are visited in list order.
+    Returns NULL after the last job.
+*/
+job *next_job_in_queue(job *curr)
+{
+    if (curr->child != NULL)
+        return curr->child;
+
+    while (curr != NULL)
+    {
+        if (curr->next != NULL)
+            return curr->next;
+
+        //Climb to the parent. Only the leftmost child points to its parent.
+        while (curr->prev != NULL && curr->prev->child != curr)
+            curr = curr->prev;
+        curr = curr->prev;
     }
 
-    return;
+    return NULL;
 }
 
 /*
@@ -140,6 +268,7 @@ void insert_job_in_ready_queue(job_queue_struct **ready_queue, job *new_job)
                 task_list!=NULL
     
     Purpose of the function: This function will remove all the low-criticality jobs from the ready queue.
+                             The heap is taken apart in a single pass, the low criticality jobs are moved to the discarded queue and the remaining jobs are requeued in O(n) time.
 
     Postconditions:
         Output: {void}
@@ -147,26 +276,39 @@ void insert_job_in_ready_queue(job_queue_struct **ready_queue, job *new_job)
 */
 void remove_jobs_from_ready_queue(job_queue_struct **ready_queue, processor_struct **processor, task *task_list, int curr_crit_lvl, int k, int core_no)
 {
-    job *free_job, *dummy_node, *prev, *curr;
-    dummy_node = malloc(sizeof(job));
-    dummy_node->task_number = -1;
-    dummy_node->job_number = -1;
-    dummy_node->next = (*ready_queue)->job_list_head;
-    prev = dummy_node;
-    curr = (*ready_queue)->job_list_head;
-
-    while(curr != NULL)
+    job *pending, *curr, *last_child, *kept = NULL;
+
+    pending = (*ready_queue)->job_list_head;
+
+    while (pending != NULL)
     {
-        // printf("Prev: %d,%d. Curr: %d,%d\n", prev->task_number, prev->job_number, curr->task_number, curr->job_number);
+        curr = pending;
+        pending = curr->next;
+
+        //Move the children of the job to the list of jobs to be checked.
+        if (curr->child != NULL)
+        {
+            last_child = curr->child;
+            while (last_child->next != NULL)
+                last_child = last_child->next;
+            last_child->next = pending;
+            pending = curr->child;
+        }
+
+        curr->child = NULL;
+        curr->next = NULL;
+        curr->prev = NULL;
+
         if(task_list[curr->task_number].criticality_lvl < curr_crit_lvl)
         {
-            free_job = curr;
-            prev->next = curr->next;
-            curr = curr->next;
             (*ready_queue)->num_jobs--;
-            free_job->next = NULL;
-            stats->total_discarded_jobs_available[core_no] += free_job->rem_exec_time;
-            insert_job_in_discarded_queue(processor, free_job, task_list, core_no);
+            //A reclaimed job dropped again has executed part of the work already counted as available when it was first discarded.
+            if (curr->reclaimed_exec_time > 0)
+                (*processor)->stats->total_discarded_jobs_executed[core_no] += TICKS_TO_UNITS(curr->reclaimed_exec_time - curr->rem_exec_time);
+            else
+                (*processor)->stats->total_discarded_jobs_available[core_no] += TICKS_TO_UNITS(curr->rem_exec_time);
+            curr->reclaimed_exec_time = 0;
+            insert_job_in_discarded_queue(processor, curr, task_list, core_no);
         }
         else
         {
@@ -177,14 +319,15 @@ void remove_jobs_from_ready_queue(job_queue_struct **ready_queue, processor_stru
             }
             curr->WCET_counter -= (task_list[curr->task_number].WCET[curr_crit_lvl - 1]);
             curr->WCET_counter += (task_list[curr->task_number].WCET[curr_crit_lvl]);
-            prev = curr;
-            curr = curr->next;
+            curr->next = kept;
+            kept = curr;
         }
     }
 
-    (*ready_queue)->job_list_head = dummy_node->next;
-    dummy_node->next = NULL;
-    free(dummy_node);
+    //The deadlines of the remaining jobs may have changed, so the heap is rebuilt from them, and the slack cache is built again when it is next used.
+    (*ready_queue)->job_list_head = merge_job_pairs(kept);
+    if ((*ready_queue)->slack_cache != NULL)
+        (*ready_queue)->slack_cache->valid = 0;
 
     return;
 }
@@ -2,82 +2,378 @@
 
 /*
     Preconditions: 
-        Input: {File pointer to input file}
-        fd!=NULL
+        Input: {Pointer to the names of the input files}
+        input_files!=NULL
 
-    Purpose of the function: Takes input from the file and returns a structure of the task set. 
+    Purpose of the function: Takes input from the text files, or from the binary taskset file if one is given, and returns a structure of the task set. 
+                             The tasks are sorted on their periods.
 
     Postconditions:
-        Output: {Pointer to the structure of taskset created}
-        task_set!=NULL
+        Output: {Pointer to the structure of taskset created, NULL if the input cannot be read}
     
 */
-task_set_struct *get_taskset(FILE *fd)
+task_set_struct *get_taskset(input_files_struct *input_files)
 {
-    int num_task, criticality_lvl;
-    int tasks;
+    task_set_struct *task_set;
 
-    FILE *input, *exec, *allocation;
-    input = fopen("input.txt", "r");
+    //A generated taskset is already numbered in the order of the periods.
+    if (input_files->generator != NULL)
+        return generate_taskset(input_files->generator);
 
-    if (input == NULL)
+    if (input_files->binary_file != NULL)
+        task_set = read_binary_taskset(input_files->binary_file);
+    else
+        task_set = read_text_taskset(input_files);
+
+    if (task_set == NULL)
+        return NULL;
+
+    //Sort the tasks list based on their periods.
+    sort_taskset(task_set);
+
+    return task_set;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to taskset, pointer to processor, the decision point}
+                The decision point is the next one of its core, and the other cores have taken their decisions up to it.
+                Unless it is a criticality change, only the state of the decision core is touched, so the cores can take their decisions on different threads (see run_parallel_epoch).
+
+    Purpose of the function: Takes the scheduling decision of the core at the decision point.
+                             At an arrival the new jobs are inserted in the ready queue, and the current job is preempted if a job with an earlier deadline has arrived.
+                             At a completion the job is removed from the ready queue and the next job is scheduled. The simulation ends if the job missed its deadline, unless it continues on a miss.
+                             At a timer expiry the core wakes up and releases the jobs that arrived while it was shut down.
+                             At a criticality change the cores of the mode switch cluster of the core raise their criticality level and drop their low criticality jobs.
+                             The entries of the cores in the event calendar of the processor are left to the caller.
+
+    Postconditions:
+        Output: {0 if the simulation ends at a deadline miss, 1 otherwise}
+*/
+int process_decision_point(task_set_struct *task_set, processor_struct *processor, decision_struct decision)
+{
+    tick_t decision_time = decision.decision_time, prev_decision_time;
+    struct timespec decision_start, decision_end;
+    int decision_point = decision.decision_point, decision_core = decision.core_no, num_core, first_core = 0, last_core = 0;
+    job *completed_job;
+
+    task *task_list = task_set->task_list;
+
+    if (processor->stats->record_latency)
+        clock_gettime(CLOCK_MONOTONIC, &decision_start);
+
+    TRACE(processor->cores[decision_core].trace, TRACE_DECISIONS, "Decision point: %s, Decision time: %.5lf, Crit level: %d\n", decision_point == ARRIVAL ? "ARRIVAL" : ((decision_point == COMPLETION) ? "COMPLETION" : ((decision_point == TIMER_EXPIRE_ERR) ? "TIMER_EXPIRE" : "CRIT_CHANGE")), TICKS_TO_UNITS(decision_time), processor->cores[decision_core].crit_level);
+
+    switch (decision_point) //all dec points are not disjoint
     {
-        printf("ERROR: Cannot open input file. Format of execution is ./test input.txt\n");
-        return 0;
+    case ARRIVAL:
+        processor->stats->total_arrival_points[decision_core]++;
+        break;
+    case COMPLETION:
+        processor->stats->total_completion_points[decision_core]++;
+        break;
+    case CRIT_CHANGE:
+        processor->stats->total_criticality_change_points[decision_core]++;
+        break;
+    case TIMER_EXPIRE_ERR:
+        processor->stats->total_wakeup_points[decision_core]++;
+        break;
     }
 
-    exec = fopen("input_times.txt", "r");
-    allocation = fopen("input_allocation.txt", "r");
+    //Remove the jobs from the discarded queue of the core that have missed their deadlines.
+    remove_jobs_from_discarded_queue(processor, decision_core, decision_time);
 
-    task_set_struct *task_set = (task_set_struct *)malloc(sizeof(task_set_struct));
+    //Store the previous decision time of core for any further use.
+    prev_decision_time = processor->cores[decision_core].total_time;
+    //Update the total time of the core.
+    processor->cores[decision_core].total_time = decision_time;
 
-    //Number of task_list
-    fscanf(input, "%d", &(task_set->total_tasks));
-    tasks = task_set->total_tasks;
-    task_set->task_list = (task *)malloc(sizeof(task) * tasks);
+    //If the decision point is due to arrival of a job
+    if (decision_point == ARRIVAL)
+    {
+        //If the currently executing job in the core is NULL, then schedule a new job from the ready queue.
+        if (processor->cores[decision_core].curr_exec_job == NULL)
+        {
+            processor->stats->total_idle_energy[decision_core] += TICKS_TO_UNITS(decision_time - prev_decision_time);
+            processor->cores[decision_core].total_idle_time += (decision_time - prev_decision_time);
+        }
+        else
+        {
+            processor->stats->total_active_energy[decision_core] += find_active_energy(decision_time - prev_decision_time, processor->cores[decision_core].frequency);
+            //Update the cycles for which the job has executed in the core and the WCET counter of the job.
+            tick_t exec_time = find_executed_cycles(processor->cores[decision_core].total_time - prev_decision_time, processor->cores[decision_core].frequency);
+            processor->cores[decision_core].curr_exec_job->rem_exec_time -= exec_time;
+            processor->cores[decision_core].curr_exec_job->WCET_counter -= exec_time;
+            update_slack_job(processor->cores[decision_core].slack_cache, processor->cores[decision_core].curr_exec_job);
+        }
+
+        //Update the newly arrived jobs in the ready queue. Discarded jobs can be inserted in ready queue or discarded queue depeneding on the maximum slack available.
+        update_job_arrivals(&(processor->cores[decision_core].ready_queue), task_set, processor->cores[decision_core].crit_level, decision_time, decision_core, &(processor->cores[decision_core]), 0);
+        update_core_frequency(processor, decision_core);
+
+        //An idle core can take back discarded jobs in the slack left after the new jobs.
+        if (processor->cores[decision_core].curr_exec_job == NULL)
+            reclaim_discarded_jobs(task_set, processor, decision_core, decision_time);
+
+        //If the currently executing job is not the head of the ready queue, then a job with earlier deadline has arrived.
+        //Preempt the current job and schedule the new job for execution.
+        if (compare_jobs(processor->cores[decision_core].curr_exec_job, processor->cores[decision_core].ready_queue->job_list_head) == 0)
+        {
+            if (processor->cores[decision_core].curr_exec_job != NULL)
+            {
+                TRACE(processor->cores[decision_core].trace, TRACE_DECISIONS, "Preempt current job | ");
+                processor->cores[decision_core].curr_exec_job->preemptions++;
+                processor->stats->total_preemptions[decision_core]++;
+            }
+            if (processor->cores[decision_core].ready_queue->num_jobs != 0)
+            {
+                schedule_new_job(&(processor->cores[decision_core]), processor->cores[decision_core].ready_queue, task_set);
+            }
+            processor->stats->total_context_switches[decision_core]++;
+        }
+    }
 
-    int cores[tasks];
-    for(int i=0; i<tasks; i++)
+    //If the decision point was due to completion of the currently executing job.
+    else if (decision_point == COMPLETION)
     {
-        int task, core;
-        fscanf(allocation, "%d%d", &task, &core);
-        cores[task] = core;
+        completed_job = processor->cores[decision_core].curr_exec_job;
+
+        //A reclaimed job that has used up the budget it was admitted with has overrun the WCET of its own level, so it is dropped and only the part it executed is counted.
+        if (completed_job->completion_time > decision_time)
+        {
+            completed_job->rem_exec_time -= find_executed_cycles(decision_time - prev_decision_time, processor->cores[decision_core].frequency);
+            TRACE(processor->cores[decision_core].trace, TRACE_DECISIONS, "Job %d, %d dropped at the end of its budget | ", completed_job->task_number, completed_job->job_number);
+            processor->stats->total_discarded_jobs_executed[decision_core] += TICKS_TO_UNITS(completed_job->reclaimed_exec_time - completed_job->rem_exec_time);
+        }
+        else
+        {
+            TRACE(processor->cores[decision_core].trace, TRACE_DECISIONS, "Job %d, %d completed execution | ", completed_job->task_number, completed_job->job_number);
+
+            //Check to see if the job has missed its deadline or not.
+            tick_t deadline = completed_job->absolute_deadline;
+            record_job_completion(processor->stats, decision_core, completed_job, processor->cores[decision_core].total_time);
+            if (deadline < processor->cores[decision_core].total_time)
+            {
+                processor->stats->total_deadline_misses[decision_core]++;
+                //Unless the simulation continues after a miss, it ends here. Otherwise the late job completes like any other, so the overload shows in the statistics.
+                if (!processor->continue_on_miss)
+                {
+                    TRACE(processor->cores[decision_core].trace, TRACE_DECISIONS, "Deadline missed. Completing scheduling\n");
+                    processor->cores[decision_core].curr_exec_job = NULL;
+                    return 0;
+                }
+                TRACE(processor->cores[decision_core].trace, TRACE_DECISIONS, "Deadline missed | ");
+            }
+
+            //The governor now accounts the task for the cycles the job executed instead of its WCET.
+            //A discarded job is not accounted, as its task releases no job at the current level, and may belong to another core.
+            if (completed_job->reclaimed_exec_time > 0)
+                processor->stats->total_discarded_jobs_executed[decision_core] += TICKS_TO_UNITS(completed_job->reclaimed_exec_time);
+            if (task_list[completed_job->task_number].core == decision_core && task_list[completed_job->task_number].criticality_lvl >= processor->cores[decision_core].crit_level)
+                set_dvfs_util(&processor->cores[decision_core], &task_list[completed_job->task_number], (double)completed_job->execution_time / (double)task_list[completed_job->task_number].virtual_deadline);
+        }
+        processor->cores[decision_core].curr_exec_job = NULL;
+        //Remove the completed job from the ready queue.
+        update_job_removal(task_set, &(processor->cores[decision_core].ready_queue), processor->cores[decision_core].job_pool);
+
+        processor->stats->total_active_energy[decision_core] += find_active_energy(decision_time - prev_decision_time, processor->cores[decision_core].frequency);
+        update_core_frequency(processor, decision_core);
+
+        //The budget the job left unused is slack the discarded jobs can reclaim before the next job is picked.
+        reclaim_discarded_jobs(task_set, processor, decision_core, decision_time);
+
+        //If ready queue is null, no job is ready for execution. Put the processor to sleep and find the next invocation time of processor.
+        if (processor->cores[decision_core].ready_queue->num_jobs == 0)
+        {
+            processor->cores[decision_core].state = ACTIVE;  //idle
+            TRACE(processor->cores[decision_core].trace, TRACE_DECISIONS, "No job to execute. Core is idle\n");
+        }
+        else
+        {
+            processor->stats->total_context_switches[decision_core]++;
+            schedule_new_job(&(processor->cores[decision_core]), processor->cores[decision_core].ready_queue, task_set);
+        }
+    }
+
+    //If the decision point is due to the expiry of the timer, the core wakes up from the shutdown.
+    else if (decision_point == TIMER_EXPIRE_ERR)
+    {
+        TRACE(processor->cores[decision_core].trace, TRACE_DECISIONS, "Core woken up | ");
+        processor->cores[decision_core].state = ACTIVE;
+        processor->cores[decision_core].next_invocation_time = TICK_MAX;
+        processor->cores[decision_core].total_idle_time += (decision_time - prev_decision_time);
+        processor->stats->total_shutdown_time[decision_core] += TICKS_TO_UNITS(decision_time - prev_decision_time);
+
+        //Release all the jobs that arrived while the core was shut down.
+        //The procrastination interval assumes the deferred jobs run at full speed, so the core is boosted until its ready queue is empty.
+        update_job_arrivals(&(processor->cores[decision_core].ready_queue), task_set, processor->cores[decision_core].crit_level, decision_time, decision_core, &(processor->cores[decision_core]), 1);
+        processor->cores[decision_core].dvfs_boost = 1;
+        update_core_frequency(processor, decision_core);
+        reclaim_discarded_jobs(task_set, processor, decision_core, decision_time);
+
+        if (processor->cores[decision_core].ready_queue->num_jobs != 0)
+        {
+            processor->stats->total_context_switches[decision_core]++;
+            schedule_new_job(&(processor->cores[decision_core]), processor->cores[decision_core].ready_queue, task_set);
+        }
     }
 
-    for (num_task = 0; num_task < tasks; num_task++)
+    //If decision point is due to criticality change, then the currently executing job has exceeded its WCET.
+    else if (decision_point == CRIT_CHANGE)
     {
-        fscanf(input, "%lf%lf%d", &task_set->task_list[num_task].phase, &task_set->task_list[num_task].relative_deadline, &task_set->task_list[num_task].criticality_lvl);
+        tick_t core_prev_decision_time;
+        int crit_level = min_int(processor->cores[decision_core].crit_level + 1, processor->total_levels - 1);
+
+        //Increase the criticality level of the cores of the mode switch cluster of the decision core. Unless the cores are clustered, it is every core of the processor.
+        find_mode_switch_cluster(processor, decision_core, &first_core, &last_core);
+        processor->crit_level = max_int(processor->crit_level, crit_level);
+
+        if (last_core - first_core == processor->total_cores)
+            TRACE(processor->cores[decision_core].trace, TRACE_DECISIONS, "Criticality changed for each core\n");
+        else if (last_core - first_core == 1)
+            TRACE(processor->cores[decision_core].trace, TRACE_DECISIONS, "Criticality changed for core %d\n", decision_core);
+        else
+            TRACE(processor->cores[decision_core].trace, TRACE_DECISIONS, "Criticality changed for cores %d to %d\n", first_core, last_core - 1);
+
+        //Remove all the low criticality jobs from the ready queue of each core of the cluster and reset the virtual deadlines of high criticality jobs.
+        for (num_core = first_core; num_core < last_core; num_core++)
+        {
+            processor->cores[num_core].crit_level = crit_level;
+            TRACE(processor->cores[num_core].trace, TRACE_DECISIONS, "Criticality changed | Crit level: %d\n", crit_level);
+
+            if (processor->cores[num_core].state == ACTIVE)
+            {
+                //Need the core's prevision decision time for updating the execution time of currently executing job.
+                if (num_core != decision_core)
+                    core_prev_decision_time = processor->cores[num_core].total_time;
+                else
+                    core_prev_decision_time = prev_decision_time;
+                processor->cores[num_core].total_time = decision_time;
+
+                //Update the time for which the current job has executed.
+                if (processor->cores[num_core].curr_exec_job != NULL)
+                {
+                    tick_t exec_time = find_executed_cycles(processor->cores[num_core].total_time - core_prev_decision_time, processor->cores[num_core].frequency);
+                    processor->cores[num_core].curr_exec_job->rem_exec_time -= exec_time;
+                    processor->cores[num_core].curr_exec_job->WCET_counter -= exec_time;
+                    update_slack_job(processor->cores[num_core].slack_cache, processor->cores[num_core].curr_exec_job);
+
+                    processor->stats->total_active_energy[num_core] += find_active_energy(processor->cores[num_core].total_time - core_prev_decision_time, processor->cores[num_core].frequency);
+                }
+                else
+                {
+                    processor->cores[num_core].total_idle_time += (processor->cores[num_core].total_time - core_prev_decision_time);
+                    processor->stats->total_idle_energy[num_core] += TICKS_TO_UNITS(processor->cores[num_core].total_time - core_prev_decision_time);
+                }
+                processor->cores[num_core].curr_exec_job = NULL;
+
+                //First remove the low criticality jobs from ready queue and insert it into discarded queue.
+                if (processor->cores[num_core].ready_queue->num_jobs != 0)
+                {
+                    remove_jobs_from_ready_queue(&processor->cores[num_core].ready_queue, &processor, task_list, crit_level, processor->cores[num_core].threshold_crit_lvl, num_core);
+                }
+            }
+
+            //The deadlines of the pending jobs are moved back from the virtual deadlines of their tasks, so the virtual deadlines are reset only after the ready queue.
+            if (crit_level > processor->cores[num_core].threshold_crit_lvl)
+                reset_virtual_deadlines(&task_set, processor, num_core, processor->cores[num_core].threshold_crit_lvl);
+
+            if (processor->cores[num_core].state == ACTIVE)
+            {
+                //The remaining tasks are accounted at their WCET of the new level, and the core runs at full speed until the jobs carried over from the lower level are done.
+                initialize_core_dvfs(task_set, processor, num_core);
+                processor->cores[num_core].dvfs_boost = 1;
+                update_core_frequency(processor, num_core);
+            }
+        }
 
-        //As it is an implicit-deadline taskset, period = deadline.
-        task_set->task_list[num_task].period = task_set->task_list[num_task].relative_deadline;
-        task_set->task_list[num_task].job_number = 0;
-        task_set->task_list[num_task].util = (double *)malloc(sizeof(double) * MAX_CRITICALITY_LEVELS);
-        task_set->task_list[num_task].core = cores[num_task];
-        task_set->task_list[num_task].WCET = malloc(sizeof(double) * MAX_CRITICALITY_LEVELS);
+        //In semi-partitioned mode the discarded jobs of every core can now migrate to the cores of the cluster with slack, before the cores pick their next job.
+        if (processor->migration == MIGRATION_SEMI_PARTITIONED)
+            distribute_discarded_jobs(task_set, processor, first_core, last_core, decision_time);
 
-        for (criticality_lvl = 0; criticality_lvl < MAX_CRITICALITY_LEVELS; criticality_lvl++)
+        for (num_core = first_core; num_core < last_core; num_core++)
         {
-            fscanf(input, "%lf", &task_set->task_list[num_task].WCET[criticality_lvl]);
-            task_set->task_list[num_task].util[criticality_lvl] = (double)task_set->task_list[num_task].WCET[criticality_lvl] / (double)task_set->task_list[num_task].period;
+            if (processor->cores[num_core].state == ACTIVE)
+            {
+                if (processor->cores[num_core].ready_queue->num_jobs != 0)
+                {
+                    processor->stats->total_context_switches[num_core]++;
+                    schedule_new_job(&processor->cores[num_core], processor->cores[num_core].ready_queue, task_set);
+                    if(num_core != decision_core)
+                        TRACE(processor->cores[num_core].trace, TRACE_DECISIONS, "Scheduled job: %d,%d  Exec time: %.5lf  Rem exec time: %.5lf  WCET_counter: %.5lf  Deadline: %.5lf\n",
+                            processor->cores[num_core].curr_exec_job->task_number,
+                            processor->cores[num_core].curr_exec_job->job_number,
+                            TICKS_TO_UNITS(processor->cores[num_core].curr_exec_job->execution_time),
+                            TICKS_TO_UNITS(processor->cores[num_core].curr_exec_job->rem_exec_time),
+                            TICKS_TO_UNITS(processor->cores[num_core].WCET_counter),
+                            TICKS_TO_UNITS(processor->cores[num_core].curr_exec_job->absolute_deadline));
+                }
+            }
         }
+    }
 
-        int num_jobs;
-        fscanf(exec, "%d", &num_jobs);
-        task_set->task_list[num_task].exec_times = malloc(sizeof(double)*num_jobs);
-        for(int i=0; i<num_jobs; i++)
+    if (processor->cores[decision_core].curr_exec_job != NULL)
+    {
+        TRACE(processor->cores[decision_core].trace, TRACE_DECISIONS, "Scheduled job: %d,%d  Exec time: %.5lf  Rem exec time: %.5lf  WCET_counter: %.5lf  Deadline: %.5lf\n",
+                processor->cores[decision_core].curr_exec_job->task_number,
+                processor->cores[decision_core].curr_exec_job->job_number,
+                TICKS_TO_UNITS(processor->cores[decision_core].curr_exec_job->execution_time),
+                TICKS_TO_UNITS(processor->cores[decision_core].curr_exec_job->rem_exec_time),
+                TICKS_TO_UNITS(processor->cores[decision_core].WCET_counter),
+                TICKS_TO_UNITS(processor->cores[decision_core].curr_exec_job->absolute_deadline));
+    }
+    //A criticality change affects every core of the cluster. Otherwise only the decision core has changed.
+    if (decision_point == CRIT_CHANGE)
+    {
+        for (num_core = first_core; num_core < last_core; num_core++)
         {
-            fscanf(exec, "%lf ", &task_set->task_list[num_task].exec_times[i]);
+            update_core_shutdown(task_set, processor, num_core);
         }
     }
+    else
+    {
+        update_core_shutdown(task_set, processor, decision_core);
+    }
 
-    //Sort the tasks list based on their periods.
-    qsort((void *)task_set->task_list, tasks, sizeof(task_set->task_list[0]), period_comparator);
+    record_histogram(&processor->stats->queue_depth[decision_core], processor->cores[decision_core].ready_queue->num_jobs);
+    if (processor->stats->record_latency)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &decision_end);
+        record_histogram(&processor->stats->decision_latency[decision_core], (decision_end.tv_sec - decision_start.tv_sec) * 1000000000LL + (decision_end.tv_nsec - decision_start.tv_nsec));
+    }
 
-    fclose(input);
-    fclose(exec);
-    fclose(allocation);
+    TRACE(processor->cores[decision_core].trace, TRACE_DECISIONS, "\n");
+    TRACE(processor->cores[decision_core].trace, TRACE_DECISIONS, "____________________________________________________________________________________________________\n\n");
 
-    return task_set;
+    return 1;
+}
+
+/*
+    Function to account the time from the last decision point of each core to the end of the super hyperperiod, once no core has a decision point left before it.
+*/
+void finish_schedule(processor_struct *processor, tick_t super_hyperperiod)
+{
+    int num_core;
+
+    for (num_core = 0; num_core < processor->total_cores; num_core++)
+    {
+        if (processor->cores[num_core].state == SHUTDOWN)
+        {
+            processor->cores[num_core].total_idle_time += (super_hyperperiod - processor->cores[num_core].total_time);
+            processor->stats->total_shutdown_time[num_core] += TICKS_TO_UNITS(super_hyperperiod - processor->cores[num_core].total_time);
+        }
+        else if (processor->cores[num_core].curr_exec_job == NULL) 
+        {
+            processor->cores[num_core].total_idle_time += (super_hyperperiod - processor->cores[num_core].total_time);
+            processor->stats->total_idle_energy[num_core] += TICKS_TO_UNITS(super_hyperperiod - processor->cores[num_core].total_time);
+        }
+        else
+        {
+            processor->cores[num_core].curr_exec_job->rem_exec_time -= find_executed_cycles(super_hyperperiod - processor->cores[num_core].total_time, processor->cores[num_core].frequency);
+            processor->stats->total_active_energy[num_core] += find_active_energy(super_hyperperiod - processor->cores[num_core].total_time, processor->cores[num_core].frequency);
+        }
+        processor->cores[num_core].total_time = super_hyperperiod;
+    }
 }
 
 /*
@@ -90,6 +386,8 @@ task_set_struct *get_taskset(FILE *fd)
                              The core will always take the head of the queue for scheduling.
                              If any job exceeds its WCET, a counter will indicate the same and the core's criticality level will change.
                              At that time, all the LOW criticality jobs will be removed from the ready queue and only HIGH criticality jobs will be scheduled from now on.
+                             With more than one thread and partitioned cores, the cores take their decisions in parallel up to the earliest time at which any of them can change its criticality level,
+                             and the decision points from there on are taken one at a time until the cores can run in parallel again.
 
     Postconditions:
         Return value: {void}
@@ -100,260 +398,115 @@ task_set_struct *get_taskset(FILE *fd)
 void schedule_taskset(task_set_struct *task_set, processor_struct *processor)
 {
 
-    double super_hyperperiod, decision_time, prev_decision_time;
+    tick_t super_hyperperiod, sync_time;
     decision_struct decision;
-    int decision_point, decision_core, num_core;
-
-    task *task_list = task_set->task_list;
-
-    job_queue_struct *discarded_queue;
-    discarded_queue = (job_queue_struct *)malloc(sizeof(job_queue_struct));
-    discarded_queue->num_jobs = 0;
-    discarded_queue->job_list_head = NULL;
+    parallel_struct *parallel = NULL;
+    int num_core, first_core, last_core;
 
     //Find the hyperperiod of all the cores. The scheduler will run for the max of all hyperperiods.
     super_hyperperiod = find_superhyperperiod(task_set);
-    fprintf(output_file, "Super hyperperiod: %.5lf\n", super_hyperperiod);
+    if (super_hyperperiod < 0)
+        return;
+    fprintf(processor->output_file, "Super hyperperiod: %.5lf\n", TICKS_TO_UNITS(super_hyperperiod));
+
+    if (processor->stats->record_tasks)
+        initialize_task_stats(processor->stats, task_set);
+
+    //Build the event calendars. The next decision point is then found in O(log n) instead of scanning every task of every core.
+    initialize_event_calendar(task_set, processor);
+    for (num_core = 0; num_core < processor->total_cores; num_core++)
+    {
+        initialize_core_dvfs(task_set, processor, num_core);
+        update_core_frequency(processor, num_core);
+        //A core whose first job arrives late can be shut down right away.
+        update_core_shutdown(task_set, processor, num_core);
+        update_core_decision_point(processor, num_core);
+    }
+
+    //A job migrated in semi-partitioned mode is touched by two cores, so those schedules are taken one decision point at a time.
+    if (processor->threads > 1 && processor->total_cores > 1 && processor->migration != MIGRATION_SEMI_PARTITIONED)
+        parallel = start_parallel_schedule(task_set, processor);
 
     while (1)
     {
         //Find the decision point. The decision point will be the minimum of the earliest arrival job, the completion of the currently executing job and the WCET counter for criticality change.
         decision = find_decision_point(task_set, processor, super_hyperperiod);
-        decision_point = decision.decision_point;
-        decision_time = decision.decision_time;
-        decision_core = decision.core_no;
 
-        if (decision_time >= super_hyperperiod)
+        if (decision.decision_time >= super_hyperperiod)
         {
-            for (num_core = 0; num_core < processor->total_cores; num_core++)
-            {
-                if (processor->cores[num_core].state == SHUTDOWN)
-                {
-                    processor->cores[num_core].total_idle_time += (super_hyperperiod - processor->cores[num_core].total_time);
-                    stats->total_shutdown_time[num_core] += (super_hyperperiod - processor->cores[num_core].total_time);
-                }
-                else if (processor->cores[num_core].curr_exec_job == NULL) 
-                {
-                    processor->cores[num_core].total_idle_time += (super_hyperperiod - processor->cores[num_core].total_time);
-                    stats->total_idle_energy[num_core] += (super_hyperperiod - processor->cores[num_core].total_time);
-                }
-                else
-                {
-                    processor->cores[num_core].curr_exec_job->rem_exec_time -= (super_hyperperiod - processor->cores[num_core].total_time);
-                    stats->total_active_energy[num_core] += (super_hyperperiod - processor->cores[num_core].total_time);
-                }
-                processor->cores[num_core].total_time = super_hyperperiod;
-            }
+            finish_schedule(processor, super_hyperperiod);
             break;
         }
 
-        fprintf(output[decision_core], "Decision point: %s, Decision time: %.5lf, Crit level: %d\n", decision_point == ARRIVAL ? "ARRIVAL" : ((decision_point == COMPLETION) ? "COMPLETION" : "CRIT_CHANGE"), decision_time, processor->crit_level);
-
-        switch (decision_point) //all dec points are not disjoint
+        //The cores run on their threads up to the synchronisation time.
+        if (parallel != NULL)
         {
-        case ARRIVAL:
-            stats->total_arrival_points[decision_core]++;
-            break;
-        case COMPLETION:
-            stats->total_completion_points[decision_core]++;
-            break;
-        case CRIT_CHANGE:
-            stats->total_criticality_change_points[decision_core]++;
-            break;
-        }
-
-        //Remove the jobs from discarded queue that have missed their deadlines.
-        remove_jobs_from_discarded_queue(&processor, decision_time);
-
-        //Store the previous decision time of core for any further use.
-        prev_decision_time = processor->cores[decision_core].total_time;
-        //Update the total time of the core.
-        processor->cores[decision_core].total_time = decision_time;
-
-        //If the decision point is due to arrival of a job
-        if (decision_point == ARRIVAL)
-        {
-            //If the currently executing job in the core is NULL, then schedule a new job from the ready queue.
-            if (processor->cores[decision_core].curr_exec_job == NULL)
-            {
-                stats->total_idle_energy[decision_core] += (decision_time - prev_decision_time);
-                processor->cores[decision_core].total_idle_time += (decision_time - prev_decision_time);
-            }
-            else
+            sync_time = find_parallel_sync_time(parallel);
+            if (decision.decision_time < sync_time)
             {
-                stats->total_active_energy[decision_core] += (decision_time - prev_decision_time);
-                //Update the time for which the job has executed in the core and the WCET counter of the job.
-                double exec_time = processor->cores[decision_core].total_time - prev_decision_time;
-                processor->cores[decision_core].curr_exec_job->rem_exec_time -= exec_time;
-                processor->cores[decision_core].curr_exec_job->WCET_counter -= exec_time;
-                if(processor->cores[decision_core].curr_exec_job->WCET_counter == 0) {
-                    decision_point = COMPLETION; //////////////////
-                } 
-            }
-
-            //Update the newly arrived jobs in the ready queue. Discarded jobs can be inserted in ready queue or discarded queue depeneding on the maximum slack available.
-            update_job_arrivals(&(processor->cores[decision_core].ready_queue), &discarded_queue, task_set, processor->crit_level, decision_time, decision_core, &(processor->cores[decision_core]), 0);
-
-            //If the currently executing job is not the head of the ready queue, then a job with earlier deadline has arrived.
-            //Preempt the current job and schedule the new job for execution.
-            if (compare_jobs(processor->cores[decision_core].curr_exec_job, processor->cores[decision_core].ready_queue->job_list_head) == 0)
-            {
-                if (processor->cores[decision_core].curr_exec_job != NULL)
-                {
-                    fprintf(output[decision_core], "Preempt current job | ");
-                }
-                if (processor->cores[decision_core].ready_queue->num_jobs != 0)
-                {
-                    schedule_new_job(&(processor->cores[decision_core]), processor->cores[decision_core].ready_queue, task_set);
-                }
-                stats->total_context_switches[decision_core]++;
+                if (!run_parallel_epoch(parallel, min_tick(sync_time, super_hyperperiod)))
+                    break;
+                continue;
             }
         }
 
-        //If the decision point was due to completion of the currently executing job.
-        else if (decision_point == COMPLETION)
-        {
-            fprintf(output[decision_core], "Job %d, %d completed execution | ", processor->cores[decision_core].curr_exec_job->task_number, processor->cores[decision_core].curr_exec_job->job_number);
-
-            //Check to see if the job has missed its deadline or not.
-            double deadline = processor->cores[decision_core].curr_exec_job->absolute_deadline;
-            if (deadline < processor->cores[decision_core].total_time)
-            {
-                fprintf(output[decision_core], "Deadline missed. Completing scheduling\n");
-                processor->cores[decision_core].curr_exec_job = NULL;
-                break;
-            }
-
-            processor->cores[decision_core].curr_exec_job = NULL;
-            //Remove the completed job from the ready queue.
-            update_job_removal(task_set, &(processor->cores[decision_core].ready_queue));
-
-            stats->total_active_energy[decision_core] += (decision_time - prev_decision_time);
+        if (!process_decision_point(task_set, processor, decision))
+            break;
 
-            //If ready queue is null, no job is ready for execution. Put the processor to sleep and find the next invocation time of processor.
-            if (processor->cores[decision_core].ready_queue->num_jobs == 0)
-            {
-                processor->cores[decision_core].state = ACTIVE;  //idle
-                fprintf(output[decision_core], "No job to execute. Core is idle\n");
-            }
-            else
-            {
-                stats->total_context_switches[decision_core]++;
-                schedule_new_job(&(processor->cores[decision_core]), processor->cores[decision_core].ready_queue, task_set);
-            }
+        //A criticality change affects every core of the cluster. Otherwise only the entry of the decision core has changed in the event calendar.
+        if (decision.decision_point == CRIT_CHANGE)
+        {
+            find_mode_switch_cluster(processor, decision.core_no, &first_core, &last_core);
         }
-
-        //If decision point is due to criticality change, then the currently executing job has exceeded its WCET.
-        else if (decision_point == CRIT_CHANGE)
+        else
         {
-            double core_prev_decision_time;
-            //Increase the criticality level of the processor.
-            processor->crit_level = min(processor->crit_level + 1, MAX_CRITICALITY_LEVELS - 1);
-
-            fprintf(output[decision_core], "Criticality changed for each core\n");
-
-            //Remove all the low criticality jobs from the ready queue of each core and reset the virtual deadlines of high criticality jobs.
-            for (num_core = 0; num_core < processor->total_cores; num_core++)
-            {
-                if (processor->crit_level > processor->cores[num_core].threshold_crit_lvl)
-                    reset_virtual_deadlines(&task_set, num_core, processor->cores[num_core].threshold_crit_lvl);
-
-                fprintf(output[num_core], "Criticality changed | Crit level: %d\n", processor->crit_level);
-
-                if (processor->cores[num_core].state == ACTIVE)
-                {
-                    //Need the core's prevision decision time for updating the execution time of currently executing job.
-                    if (num_core != decision_core)
-                        core_prev_decision_time = processor->cores[num_core].total_time;
-                    else
-                        core_prev_decision_time = prev_decision_time;
-                    processor->cores[num_core].total_time = decision_time;
-
-                    //Update the time for which the current job has executed.
-                    if (processor->cores[num_core].curr_exec_job != NULL)
-                    {
-                        processor->cores[num_core].curr_exec_job->rem_exec_time -= (processor->cores[num_core].total_time - core_prev_decision_time);
-                        processor->cores[num_core].curr_exec_job->WCET_counter -= (processor->cores[num_core].total_time - core_prev_decision_time);
-
-                        stats->total_active_energy[num_core] += (processor->cores[num_core].total_time - core_prev_decision_time);
-                    }
-                    else
-                    {
-                        processor->cores[num_core].total_idle_time += (processor->cores[num_core].total_time - core_prev_decision_time);
-                        stats->total_idle_energy[num_core] += (processor->cores[num_core].total_time - core_prev_decision_time);
-                    }
-                    processor->cores[num_core].curr_exec_job = NULL;
-
-                    //First remove the low criticality jobs from ready queue and insert it into discarded queue.
-                    if (processor->cores[num_core].ready_queue->num_jobs != 0)
-                    {
-                        remove_jobs_from_ready_queue(&processor->cores[num_core].ready_queue, &processor, task_list, processor->crit_level, processor->cores[num_core].threshold_crit_lvl, num_core);
-                    }
-
-                    if (processor->cores[num_core].ready_queue->num_jobs != 0)
-                    {
-                        stats->total_context_switches[num_core]++;
-                        schedule_new_job(&processor->cores[num_core], processor->cores[num_core].ready_queue, task_set);
-                        if(num_core != decision_core)
-                            fprintf(output[num_core], "Scheduled job: %d,%d  Exec time: %.5lf  Rem exec time: %.5lf  WCET_counter: %.5lf  Deadline: %.5lf\n",
-                                processor->cores[num_core].curr_exec_job->task_number,
-                                processor->cores[num_core].curr_exec_job->job_number,
-                                processor->cores[num_core].curr_exec_job->execution_time,
-                                processor->cores[num_core].curr_exec_job->rem_exec_time,
-                                processor->cores[num_core].WCET_counter,
-                                processor->cores[num_core].curr_exec_job->absolute_deadline);
-                    }
-                }
-            }
+            first_core = decision.core_no;
+            last_core = first_core + 1;
         }
-
-        if (processor->cores[decision_core].curr_exec_job != NULL)
+        for (num_core = first_core; num_core < last_core; num_core++)
         {
-            fprintf(output[decision_core], "Scheduled job: %d,%d  Exec time: %.5lf  Rem exec time: %.5lf  WCET_counter: %.5lf  Deadline: %.5lf\n",
-                    processor->cores[decision_core].curr_exec_job->task_number,
-                    processor->cores[decision_core].curr_exec_job->job_number,
-                    processor->cores[decision_core].curr_exec_job->execution_time,
-                    processor->cores[decision_core].curr_exec_job->rem_exec_time,
-                    processor->cores[decision_core].WCET_counter,
-                    processor->cores[decision_core].curr_exec_job->absolute_deadline);
+            update_core_decision_point(processor, num_core);
+            if (parallel != NULL)
+                update_core_sync_time(parallel, num_core);
         }
-        fprintf(output[decision_core], "\n");
-        fprintf(output[decision_core], "____________________________________________________________________________________________________\n\n");
     }
+
+    if (parallel != NULL)
+        stop_parallel_schedule(parallel);
+
     return;
 }
 
 /*
     Preconditions: 
-        Input: {pointer to taskset, pointer to core, pointer to output file}
+        Input: {pointer to taskset, pointer to processor, name of the cores file}
 
     Purpose of the function: This function will perform the offline preprocessing phase and the runtime scheduling of edf-vd.
                             If the taskset is not schedulable, it will return after displaying the same message. Else, it will start the runtime scheduling of the tasket.
                         
     Postconditions: 
-        Output: {void}
+        Output: {1 if the taskset was allocated and scheduled, 0 if it is not schedulable}
 */
-void runtime_scheduler(task_set_struct *task_set, processor_struct *processor)
+int runtime_scheduler(task_set_struct *task_set, processor_struct *processor, char *cores_file)
 {
-    // int result = 1;
-    int result = allocate_tasks_to_cores(task_set, processor);
-    print_task_list(task_set);
+    int result = allocate_tasks_to_cores(task_set, processor, cores_file);
+    print_task_list(processor->output_file, task_set);
 
     if (result == 0.00)
     {
-        fprintf(output_file, "Not schedulable\n");
-        return;
+        fprintf(processor->output_file, "Not schedulable\n");
+        return 0;
     }
     else
     {
-        fprintf(output_file, "Schedulable\n");
+        fprintf(processor->output_file, "Schedulable\n");
     }
 
-    srand(time(NULL));
-
+    start_trace_drain(processor);
     schedule_taskset(task_set, processor);
+    stop_trace_drain(processor);
     print_processor(processor);
 
-    return;
+    return 1;
 }
 
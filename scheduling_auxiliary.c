@@ -6,309 +6,722 @@
                 task_set!=NULL
 
     Purpose of the function: The function will find the hyperperiod of all the tasks in the taskset. The core will run for exactly one hyperperiod.
+                             The hyperperiod is the lcm of the periods in ticks, so it is exact for any periods that are multiples of the tick.
 
     Postconditions:
-        Output: {The hyperperiod is returned}
+        Output: {The hyperperiod is returned, or -1 if it does not fit in a tick_t}
         
 */
-double find_superhyperperiod(task_set_struct *task_set)
+tick_t find_superhyperperiod(task_set_struct *task_set)
 {
-    double lcm;
+    tick_t hyperperiod;
     int num_task;
 
-    lcm = 1;
+    hyperperiod = 1;
     for (num_task = 0; num_task < task_set->total_tasks; num_task++)
     {
-        lcm = (lcm * task_set->task_list[num_task].period) / gcd(lcm, task_set->task_list[num_task].period);
+        hyperperiod = lcm(hyperperiod, task_set->period_table[num_task]);
+        if (hyperperiod < 0)
+        {
+            printf("ERROR: The hyperperiod of the taskset overflows at task %d\n", num_task);
+            return -1;
+        }
     }
 
-    return lcm;
+    return hyperperiod;
 }
 
 /*
     Preconditions:
-        Input: {pointer to taskset, current criticality level} 
+        Input: {pointer to core}
     
     Purpose of the function: This function finds the time of earliest arriving job. 
+                             The next release of every task of the core is kept in the arrival calendar of the core, so the earliest arrival is the top of the heap.
 
     Postconditions:
         Output: {The arrival time of earliest arriving job}
 
 */
-double find_earliest_arrival_job(task_set_struct *task_set, int core_no, int curr_crit_level)
+tick_t find_earliest_arrival_job(core_struct *core)
 {
+    event_struct *event = find_min_event(core->arrival_calendar);
 
-    double min_arrival_time = INT_MAX;
-    int i;
+    if (event == NULL)
+        return TICK_MAX;
+
+    return event->time;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to taskset, pointer to processor}
+                task_set!=NULL
+                processor!=NULL
+
+    Purpose of the function: This function builds the event calendars used to find the decision points.
+                             Each core gets an arrival calendar holding the next release of each of its tasks. The arrival calendars share one position array, as every task belongs to exactly one core.
+                             The processor gets an event calendar holding the next decision time of each core.
 
+    Postconditions:
+        Output: {void}
+*/
+void initialize_event_calendar(task_set_struct *task_set, processor_struct *processor)
+{
+    int i, core_no;
+    int *task_position, *num_core_tasks;
+    task *task_list = task_set->task_list;
+
+    task_position = (int *)malloc(sizeof(int) * max_int(task_set->total_tasks, 1));
+    processor->arrival_position = task_position;
+    num_core_tasks = (int *)calloc(processor->total_cores, sizeof(int));
     for (i = 0; i < task_set->total_tasks; i++)
     {
-        if (task_set->task_list[i].core == core_no)
+        task_position[i] = -1;
+        if (task_list[i].core >= 0 && task_list[i].core < processor->total_cores)
+            num_core_tasks[task_list[i].core]++;
+    }
+
+    for (core_no = 0; core_no < processor->total_cores; core_no++)
+    {
+        processor->cores[core_no].arrival_calendar = initialize_event_heap(num_core_tasks[core_no], task_position);
+        processor->cores[core_no].released_tasks = (int *)malloc(sizeof(int) * max_int(num_core_tasks[core_no], 1));
+    }
+    free(num_core_tasks);
+
+    for (i = 0; i < task_set->total_tasks; i++)
+    {
+        if (task_list[i].core >= 0 && task_list[i].core < processor->total_cores)
         {
-            min_arrival_time = min(min_arrival_time, task_set->task_list[i].phase + task_set->task_list[i].period * task_set->task_list[i].job_number);
+            update_event(processor->cores[task_list[i].core].arrival_calendar, i, task_set->release_table[i]);
         }
     }
 
-    return min_arrival_time;
+    processor->event_calendar = initialize_event_heap(processor->total_cores, NULL);
+    for (core_no = 0; core_no < processor->total_cores; core_no++)
+    {
+        update_core_decision_point(processor, core_no);
+    }
+
+    return;
 }
 
 /*
     Preconditions: 
-        Input: {pointer to taskset, pointer to ready queue, pointer to core}
+        Input: {pointer to processor, the core number}
 
-    Purpose of the function: This function will find the next decision point of the core. 
+    Purpose of the function: This function will find the next decision point of the given core. 
                              The decision point will be the minimum of the earliest arrival job, the completion time of currently executing job, the WCET counter of currently executing job and the timer expiry of the core.
+                             The WCET counter of a reclaimed job is the end of its budget, which is a completion point where the job is dropped.
 
     Postconditions: 
         Output: {the decision point, decision time}
         Decision point = ARRIVAL or COMPLETION or TIMER_EXPIRE_ERR or CRIT_CHANGE
-        
-  
 */
-decision_struct find_decision_point(task_set_struct *task_set, processor_struct *processor, double super_hyperperiod)
+decision_struct find_core_decision_point(processor_struct *processor, int core_no)
 {
-
-    double arrival_time, completion_time, expiry_time, WCET_counter;
-    double min_time;
+    tick_t arrival_time, completion_time, expiry_time, WCET_counter;
+    core_struct *core = &(processor->cores[core_no]);
     decision_struct decision;
-    double decision_time = INT_MAX;
-    int decision_core;
-    int decision_point;
-    int i, flag = 0;
 
-    decision.core_no = -1;
+    completion_time = TICK_MAX;
+    expiry_time = TICK_MAX;
+    WCET_counter = TICK_MAX;
+    arrival_time = TICK_MAX;
 
-    // fprintf(output[decision_core], "Finding decision point\n");
-    for (i = 0; i < processor->total_cores; i++)
+    if (core->state == ACTIVE)
     {
-        completion_time = INT_MAX;
-        expiry_time = INT_MAX;
-        WCET_counter = INT_MAX;
-        arrival_time = INT_MAX;
-        flag = 0;
+        arrival_time = find_earliest_arrival_job(core);
+    }
+    else
+    {
+        expiry_time = core->next_invocation_time;
+    }
 
-        if (processor->cores[i].state == ACTIVE)
+    if (core->curr_exec_job != NULL)
+    {
+        completion_time = core->curr_exec_job->completion_time;
+        //A reclaimed job runs at most for the slack it was admitted with, so its WCET counter ends the job instead of changing the criticality level.
+        if (core->curr_exec_job->reclaimed_exec_time > 0)
         {
-            arrival_time = find_earliest_arrival_job(task_set, i, processor->crit_level);
+            completion_time = min_tick(completion_time, core->WCET_counter);
         }
-        else
+        else if (core->crit_level < (processor->total_levels - 1))
         {
-            expiry_time = processor->cores[i].next_invocation_time;
+            WCET_counter = core->WCET_counter;
         }
+    }
 
-        if (processor->cores[i].curr_exec_job != NULL)
-        {
-            flag = 1;
-            completion_time = processor->cores[i].curr_exec_job->completion_time;
-            if (processor->crit_level < (MAX_CRITICALITY_LEVELS - 1))
-            {
-                WCET_counter = processor->cores[i].WCET_counter;
-            }
-        }
+    decision.core_no = core_no;
+    decision.decision_time = min_tick(min_tick(min_tick(arrival_time, completion_time), WCET_counter), expiry_time);
 
-        min_time = min(min(min(arrival_time, completion_time), WCET_counter), expiry_time);
-        if (decision_time > min_time)
-        {
-            decision_time = min_time;
-            decision_core = i;
+    if (decision.decision_time == completion_time)
+    {
+        decision.decision_point = COMPLETION;
+    }
+    else if (decision.decision_time == expiry_time)
+    {
+        decision.decision_point = TIMER_EXPIRE_ERR;
+    }
+    else if (decision.decision_time == WCET_counter)
+    {
+        decision.decision_point = CRIT_CHANGE;
+    }
+    else
+    {
+        decision.decision_point = ARRIVAL;
+    }
 
-            if (decision_time == completion_time)
-            {
-                decision_point = COMPLETION;
-            }
-            else if (decision_time == expiry_time)
-            {
-                decision_point = TIMER_EXPIRE_ERR;
-            }
-            else if (decision_time == WCET_counter)
-            {
-                decision_point = CRIT_CHANGE;
-            }
-            else if (decision_time == arrival_time)
-            {
-                decision_point = ARRIVAL;
-            }
-            // fprintf(output[i], "Core: %d, Curr job: %d,%d. Arrival time: %.5lf, Completion time: %.5lf, Timer expiry: %.5lf, WCET counter: %.5lf\n", i, (flag == 1 ? processor->cores[i].curr_exec_job->task_number : -1), (flag == 1 ? processor->cores[i].curr_exec_job->job_number : -1), arrival_time, completion_time, expiry_time, WCET_counter);
-        }
+    return decision;
+}
+
+/*
+    Function to update the entry of the core in the event calendar of the processor.
+    It has to be called whenever the arrival calendar, the currently executing job, the WCET counter or the state of the core changes.
+*/
+void update_core_decision_point(processor_struct *processor, int core_no)
+{
+    decision_struct decision = find_core_decision_point(processor, core_no);
+
+    update_event(processor->event_calendar, core_no, decision.decision_time);
+
+    return;
+}
+
+/*
+    Function to find the mode switch cluster of the core. The cores first_core to last_core - 1 change their criticality level together, and unless the cores are clustered it is every core of the processor.
+*/
+void find_mode_switch_cluster(processor_struct *processor, int core_no, int *first_core, int *last_core)
+{
+    int cluster_size = (processor->mode_switch_cluster > 0) ? processor->mode_switch_cluster : processor->total_cores;
+
+    *first_core = core_no / cluster_size * cluster_size;
+    *last_core = min_int(*first_core + cluster_size, processor->total_cores);
+}
+
+/*
+    Preconditions: 
+        Input: {pointer to taskset, pointer to processor, the super hyperperiod}
+
+    Purpose of the function: This function will find the next decision point of the processor. 
+                             The core with the earliest decision time is the top of the event calendar of the processor. Ties are broken in favour of the lower core.
+
+    Postconditions: 
+        Output: {the decision point, decision time}
+        Decision point = ARRIVAL or COMPLETION or TIMER_EXPIRE_ERR or CRIT_CHANGE
+        
+  
+*/
+decision_struct find_decision_point(task_set_struct *task_set, processor_struct *processor, tick_t super_hyperperiod)
+{
+    event_struct *event = find_min_event(processor->event_calendar);
+    decision_struct decision;
+
+    if (event == NULL)
+    {
+        decision.core_no = 0;
+        decision.decision_point = ARRIVAL;
+        decision.decision_time = TICK_MAX;
+        return decision;
     }
 
-    decision.core_no = decision_core;
-    decision.decision_point = decision_point;
-    decision.decision_time = decision_time;
+    return find_core_decision_point(processor, event->id);
+}
 
-    return decision;
+/*
+    Function to compare the jobs of the slack cache on their deadlines. Jobs with the same deadline are kept in the order they were inserted in the ready queue, which is where a new job is inserted in the cache.
+*/
+int slack_job_comparator(const void *A, const void *B)
+{
+    const job *a = *(job *const *)A;
+    const job *b = *(job *const *)B;
+    if (a->absolute_deadline != b->absolute_deadline)
+        return (a->absolute_deadline > b->absolute_deadline) - (a->absolute_deadline < b->absolute_deadline);
+    return (a->queue_order > b->queue_order) - (a->queue_order < b->queue_order);
+}
+
+/*
+    Function to find the position of the slack cache after the jobs due by the deadline, with a binary search on the sorted deadlines.
+*/
+int find_slack_position(slack_cache_struct *cache, tick_t deadline)
+{
+    int low = 0, high = cache->num_jobs, mid;
+
+    while (low < high)
+    {
+        mid = (low + high) / 2;
+        if (cache->jobs[2 * mid] > deadline)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+
+    return low;
+}
+
+/*
+    Function to find the position of the job in the slack cache, -1 if it is not in the cache. The jobs with the same deadline are searched one by one.
+*/
+int find_slack_job(slack_cache_struct *cache, job *curr_job)
+{
+    int position = find_slack_position(cache, curr_job->absolute_deadline);
+
+    while (--position >= 0 && cache->jobs[2 * position] == curr_job->absolute_deadline)
+    {
+        if (cache->entries[position] == curr_job)
+            return position;
+    }
+    return -1;
+}
+
+/*
+    Function to set the (deadline, remaining WCET) pair of the job at the given position of the slack cache, and its density at the time of the cache.
+*/
+void set_slack_job(slack_cache_struct *cache, job *curr_job, int position)
+{
+    task *curr_task = &cache->task_list[curr_job->task_number];
+
+    cache->entries[position] = curr_job;
+    cache->jobs[2 * position] = curr_job->absolute_deadline;
+    cache->jobs[2 * position + 1] = curr_task->WCET[curr_task->criticality_lvl] - (curr_job->execution_time - curr_job->rem_exec_time);
+    get_kernels()->find_demand_densities(cache->density + position, cache->jobs + 2 * position, 1, (double)cache->time);
 }
 
 /*
     Preconditions:
-        Input: {pointer to taskset, pointer to ready queue, the current crit level, the core number, the curr time and the deadline}
-                task_set!=NULL
-                ready_queue!=NULL
+        Input: {pointer to the slack cache, the position of the first job that changed}
+                The pairs and the densities of the cache are up to date, and the sums of the jobs after the position are those of the same jobs before the change.
 
-    Function to find the maximum slack between the discarded job's deadline and the current time.
+    Purpose of the function: Finds the prefix sums of the remaining WCETs from the position on, and the suffix sums of the densities from the position back to the first job.
+                             The sums are added in the same order as when the cache is built, so they are equal to those of a cache built from the ready queue.
 
     Postconditions:
-        Output: {The maximum slack available between the current time and the deadline for the given core}
+        Output: {void}
+*/
+void update_slack_sums(slack_cache_struct *cache, int position)
+{
+    int i;
+
+    for (i = position; i < cache->num_jobs; i++)
+    {
+        cache->prefix_demand[i + 1] = cache->prefix_demand[i] + cache->jobs[2 * i + 1];
+    }
+    cache->suffix_density[cache->num_jobs] = 0;
+    for (i = min_int(position, cache->num_jobs - 1); i >= 0; i--)
+    {
+        cache->suffix_density[i] = cache->density[i] + cache->suffix_density[i + 1];
+    }
+}
+
+/*
+    Function to make room in the slack cache for at least the given number of jobs.
 */
-double find_max_slack(task_set_struct *task_set, int crit_level, int core_no, double deadline, double curr_time, job_queue_struct *ready_queue)
+void reserve_slack_cache(slack_cache_struct *cache, int num_jobs)
 {
-    int i, task_number, task_crit_level;
-    double max_slack = deadline - curr_time;
+    if (cache->capacity >= num_jobs + 1)
+        return;
+
+    cache->capacity = 2 * (num_jobs + 1);
+    cache->jobs = (double *)realloc(cache->jobs, sizeof(double) * cache->capacity * 2);
+    cache->entries = (job **)realloc(cache->entries, sizeof(job *) * cache->capacity);
+    cache->prefix_demand = (double *)realloc(cache->prefix_demand, sizeof(double) * cache->capacity);
+    cache->density = (double *)realloc(cache->density, sizeof(double) * cache->capacity);
+    cache->suffix_density = (double *)realloc(cache->suffix_density, sizeof(double) * cache->capacity);
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the slack cache, pointer to the job inserted in the ready queue}
 
-    fprintf(output[core_no], "Function to find maximum slack\n");
-    fprintf(output[core_no], "Max slack: %.5lf, Deadline: %.5lf, Curr time: %.5lf\n", max_slack, deadline, curr_time);
+    Purpose of the function: Inserts the job in the slack cache of the ready queue after the jobs with the same deadline, which are found with a binary search.
+                             The jobs after it are shifted, and the sums are found again from its position. A cache that is not built is left to be built when it is used.
 
-    job *temp = ready_queue->job_list_head;
+    Postconditions:
+        Output: {void}
+*/
+void insert_slack_job(slack_cache_struct *cache, job *new_job)
+{
+    int position;
+
+    if (cache == NULL || !cache->valid)
+        return;
 
-    fprintf(output[core_no], "Traversing ready queue\n");
+    reserve_slack_cache(cache, cache->num_jobs + 1);
+    position = find_slack_position(cache, new_job->absolute_deadline);
+    memmove(cache->jobs + 2 * (position + 1), cache->jobs + 2 * position, sizeof(double) * 2 * (cache->num_jobs - position));
+    memmove(cache->entries + position + 1, cache->entries + position, sizeof(job *) * (cache->num_jobs - position));
+    memmove(cache->density + position + 1, cache->density + position, sizeof(double) * (cache->num_jobs - position));
+    memmove(cache->suffix_density + position + 1, cache->suffix_density + position, sizeof(double) * (cache->num_jobs - position + 1));
+    cache->num_jobs++;
 
-    //First traverse the ready queue and update the maximum slack according to remaining execution time of jobs.
-    while (temp)
+    set_slack_job(cache, new_job, position);
+    update_slack_sums(cache, position);
+}
+
+/*
+    Function to remove the job removed from the ready queue from its slack cache. The jobs after it are shifted, and the sums are found again from its position.
+*/
+void remove_slack_job(slack_cache_struct *cache, job *old_job)
+{
+    int position;
+
+    if (cache == NULL || !cache->valid)
+        return;
+
+    position = find_slack_job(cache, old_job);
+    if (position < 0)
+    {
+        cache->valid = 0;
+        return;
+    }
+
+    memmove(cache->jobs + 2 * position, cache->jobs + 2 * (position + 1), sizeof(double) * 2 * (cache->num_jobs - position - 1));
+    memmove(cache->entries + position, cache->entries + position + 1, sizeof(job *) * (cache->num_jobs - position - 1));
+    memmove(cache->density + position, cache->density + position + 1, sizeof(double) * (cache->num_jobs - position - 1));
+    memmove(cache->suffix_density + position, cache->suffix_density + position + 1, sizeof(double) * (cache->num_jobs - position));
+    cache->num_jobs--;
+
+    update_slack_sums(cache, position);
+}
+
+/*
+    Function to update the remaining WCET of a job of the slack cache after it has executed. The sums are found again from its position.
+*/
+void update_slack_job(slack_cache_struct *cache, job *curr_job)
+{
+    int position;
+
+    if (cache == NULL || !cache->valid)
+        return;
+
+    position = find_slack_job(cache, curr_job);
+    if (position < 0)
+    {
+        cache->valid = 0;
+        return;
+    }
+
+    set_slack_job(cache, curr_job, position);
+    update_slack_sums(cache, position);
+}
+
+/*
+    Preconditions:
+        Input: {pointer to taskset, pointer to core, current time}
+
+    Purpose of the function: Brings the slack cache of the core to the current time. The pairs are kept in ticks.
+                             A cache that is not valid is built from the ready queue: the pairs are sorted on the deadline, and the prefix sums of the remaining WCETs and the suffix sums of the demand densities are stored,
+                             so that the demand of the ready queue up to any deadline is found with one binary search.
+                             A valid cache already follows the jobs of the queue, so at a new time only the densities and their suffix sums are found again, without sorting the jobs.
+
+    Postconditions:
+        Output: {Pointer to the slack cache}
+*/
+slack_cache_struct *update_slack_cache(task_set_struct *task_set, core_struct *core, tick_t curr_time)
+{
+    slack_cache_struct *cache = core->slack_cache;
+    job_queue_struct *ready_queue = core->ready_queue;
+    double *jobs;
+    job *temp;
+    int i, task_crit_level;
+
+    if (cache->valid && cache->time == curr_time)
+        return cache;
+
+    if (!cache->valid)
     {
-        task_number = temp->task_number;
-        task_crit_level = task_set->task_list[task_number].criticality_lvl;
-        double rem_exec_time = task_set->task_list[task_number].WCET[task_crit_level] - (temp->execution_time - temp->rem_exec_time);
+        reserve_slack_cache(cache, ready_queue->num_jobs);
 
-        if(temp->absolute_deadline > deadline) {
-            max_slack -= (deadline - curr_time) / (temp->absolute_deadline - curr_time) * rem_exec_time;
+        //Sort the jobs on the deadline, and collect their (deadline, remaining WCET) pairs.
+        jobs = cache->jobs;
+        cache->num_jobs = 0;
+        for (temp = ready_queue->job_list_head; temp != NULL; temp = next_job_in_queue(temp))
+        {
+            cache->entries[cache->num_jobs++] = temp;
         }
-        else {
-            max_slack -= rem_exec_time;
+        qsort((void *)cache->entries, cache->num_jobs, sizeof(job *), slack_job_comparator);
+
+        cache->prefix_demand[0] = 0;
+        for (i = 0; i < cache->num_jobs; i++)
+        {
+            temp = cache->entries[i];
+            task_crit_level = task_set->task_list[temp->task_number].criticality_lvl;
+            jobs[2 * i] = temp->absolute_deadline;
+            jobs[2 * i + 1] = task_set->task_list[temp->task_number].WCET[task_crit_level] - (temp->execution_time - temp->rem_exec_time);
+            cache->prefix_demand[i + 1] = cache->prefix_demand[i] + jobs[2 * i + 1];
         }
-        fprintf(output[core_no], "Job: %d, rem execution time: %.5lf, deadline: %.5lf, max slack: %.5lf\n", temp->task_number, rem_exec_time, temp->absolute_deadline, max_slack);
-        temp = temp->next;
+        cache->task_list = task_set->task_list;
+        cache->valid = 1;
     }
 
-    fprintf(output[core_no], "Traversing task list\n");
-    //Then, traverse the task list and update the maximum slack according to future invocations of the tasks.
-    for (i = 0; i < task_set->total_tasks; i++)
+    //The densities of the jobs are found by the kernels, and then summed from the last job back.
+    cache->time = curr_time;
+    get_kernels()->find_demand_densities(cache->density, cache->jobs, cache->num_jobs, (double)curr_time);
+    update_slack_sums(cache, cache->num_jobs);
+
+    return cache;
+}
+
+/*
+    Function to find the demand of the ready queue between the current time and the deadline.
+    A job due by the deadline needs its remaining WCET, and a job due later needs the share of it proportional to (deadline - time) / (job deadline - time).
+*/
+double find_ready_queue_demand(slack_cache_struct *cache, tick_t deadline, tick_t curr_time)
+{
+    //Find the number of jobs due by the deadline.
+    int position = find_slack_position(cache, deadline);
+
+    return cache->prefix_demand[position] + (deadline - curr_time) * cache->suffix_density[position];
+}
+
+/*
+    Preconditions:
+        Input: {pointer to taskset, the task number, deadline}
+
+    Purpose of the function: Finds the demand of the jobs of the task that are not released yet and are released before the deadline, in closed form.
+                             Jobs whose virtual deadline is by the deadline need their full WCET, the others need the share (deadline - release) / period of it.
+                             The job indices are found with integer division on the ticks, so they match the comparisons on the release times exactly.
+
+    Postconditions:
+        Output: {The demand of the future jobs of the task in ticks}
+*/
+double find_future_demand(task_set_struct *task_set, int num_task, tick_t deadline)
+{
+    task *curr_task = &task_set->task_list[num_task];
+    tick_t phase = task_set->phase_table[num_task];
+    tick_t period = task_set->period_table[num_task];
+    tick_t exec_time = curr_task->WCET[curr_task->criticality_lvl];
+    tick_t first = task_set->job_number_table[num_task], last, last_full, num_partial, span;
+    double demand;
+
+    if (task_set->release_table[num_task] >= deadline)
+        return 0;
+
+    //The last job released before the deadline.
+    last = (deadline - phase + period - 1) / period - 1;
+
+    //The last job whose virtual deadline is by the deadline.
+    span = deadline - curr_task->virtual_deadline - phase;
+    last_full = (span >= 0) ? span / period : -1;
+    if (last_full < first - 1)
+        last_full = first - 1;
+    if (last_full > last)
+        last_full = last;
+
+    demand = (double)((last_full - first + 1) * exec_time);
+
+    //Sum of (deadline - phase - period * n) / period * exec_time over the jobs last_full + 1 to last.
+    num_partial = last - last_full;
+    if (num_partial > 0)
+        demand += (double)exec_time / period * (num_partial * (double)(deadline - phase) - period * (double)(last_full + 1 + last) * num_partial / 2.0);
+
+    return demand;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to taskset, pointer to processor, the current crit level, the core number, the deadline and the curr time}
+                task_set!=NULL
+
+    Function to find the maximum slack between the discarded job's deadline and the current time. It is the time left after the demand bound of the ready queue
+    and of the future jobs of the tasks of the core at or above the criticality level. The ready queue demand comes from the slack cache of the core,
+    which follows the jobs of the queue and finds its densities again only when the time changes, and the demand of each task is found in O(1).
+
+    Postconditions:
+        Output: {The maximum slack available between the current time and the deadline for the given core, rounded down to a tick}
+*/
+tick_t find_max_slack(task_set_struct *task_set, processor_struct *processor, int crit_level, int core_no, tick_t deadline, tick_t curr_time)
+{
+    core_struct *core = &processor->cores[core_no];
+    trace_struct *trace = core->trace;
+    slack_cache_struct *cache = update_slack_cache(task_set, core, curr_time);
+    double max_slack = (double)(deadline - curr_time);
+    double demand;
+    int i, num_task;
+
+    TRACE(trace, TRACE_VERBOSE, "Function to find maximum slack\n");
+    TRACE(trace, TRACE_VERBOSE, "Max slack: %.5lf, Deadline: %.5lf, Curr time: %.5lf\n", TICKS_TO_UNITS(max_slack), TICKS_TO_UNITS(deadline), TICKS_TO_UNITS(curr_time));
+
+    //First subtract the demand of the jobs in the ready queue.
+    demand = find_ready_queue_demand(cache, deadline, curr_time);
+    max_slack -= demand;
+    TRACE(trace, TRACE_VERBOSE, "Ready queue: %d jobs, demand: %.5lf, max slack: %.5lf\n", cache->num_jobs, TICKS_TO_UNITS(demand), TICKS_TO_UNITS(max_slack));
+
+    //Then, subtract the demand of the future invocations of the tasks of the core of at least the criticality level.
+    for (i = core->level_index[crit_level]; i < core->level_index[processor->total_levels]; i++)
     {
-        if (task_set->task_list[i].core == core_no && task_set->task_list[i].criticality_lvl >= crit_level)
+        num_task = core->task_index[i];
+        demand = find_future_demand(task_set, num_task, deadline);
+        if (demand > 0)
         {
-            int curr_jobs = task_set->task_list[i].job_number;
-            task_crit_level = task_set->task_list[i].criticality_lvl;
-            double exec_time = task_set->task_list[i].WCET[task_crit_level];
-            double release_time;
-            while ((release_time = (task_set->task_list[i].phase + task_set->task_list[i].period * curr_jobs)) < deadline)
-            {
-                double task_deadline = (release_time + task_set->task_list[i].virtual_deadline);
-                if(task_deadline > deadline) {
-                    max_slack -= (deadline - release_time) / task_set->task_list[i].period * exec_time;
-                }
-                else {
-                    max_slack -= exec_time;
-                }
-                fprintf(output[core_no], "Task: %d, exec time: %.5lf, deadline: %.5lf, max slack: %.5lf\n", i, exec_time, task_deadline, max_slack);
-                curr_jobs++;
-            }
+            max_slack -= demand;
+            TRACE(trace, TRACE_VERBOSE, "Task: %d, demand: %.5lf, max slack: %.5lf\n", num_task, TICKS_TO_UNITS(demand), TICKS_TO_UNITS(max_slack));
         }
     }
 
-    return max(max_slack, 0.00);
+    return (max_slack > 0) ? (tick_t)floor(max_slack) : 0;
 }
 
-void accommodate_discarded_jobs(job_queue_struct **ready_queue, job_queue_struct **discarded_queue, task_set_struct *task_set, int core_no, int curr_crit_level, double curr_time)
-{
-    job *ready_job, *prev, *curr, *dummy_node;
+/*
+    Preconditions:
+        Input: {pointer to the ready queue of the core, pointer to the discarded queue, pointer to taskset, pointer to processor, the core number, the current crit level, the current time}
 
-    dummy_node = (job*)malloc(sizeof(job));
-    dummy_node->next = (*discarded_queue)->job_list_head;
+    Purpose of the function: Moves the discarded jobs that fit in the slack of the core to its ready queue, from the highest criticality level down and in deadline order within a level.
+                             At each level the jobs of the tasks of the core are tried before the jobs of the other cores, which migrate to the core.
+                             A job is admitted if the maximum slack of the core up to its deadline covers the WCET at its own level less what it has executed.
+                             This is the budget of the job: it is dropped if it has not completed when the budget runs out, so it cannot trigger a criticality change.
 
-    double max_slack, rem_exec_time;
+    Postconditions:
+        Output: {void}
+        Result: The admitted jobs are in the ready queue and the migrations are counted on the core.
+*/
+void accommodate_discarded_jobs(job_queue_struct **ready_queue, job_queue_struct **discarded_queue, task_set_struct *task_set, processor_struct *processor, int core_no, int curr_crit_level, tick_t curr_time)
+{
+    trace_struct *trace = processor->cores[core_no].trace;
+    job *ready_job, *curr, **link;
+
+    tick_t max_slack, rem_exec_time;
     int crit_level;
 
-    fprintf(output[core_no], "Discarded job list\n");
-    print_job_list(core_no, (*discarded_queue)->job_list_head);
+    TRACE(trace, TRACE_VERBOSE, "Discarded job list\n");
+    trace_job_list(trace, TRACE_VERBOSE, (*discarded_queue)->job_list_head);
 
     if ((*discarded_queue)->num_jobs == 0)
         return;
 
-    fprintf(output[core_no], "Accommodating discarded jobs in ready queue of core %d\n", core_no);
+    TRACE(trace, TRACE_JOBS, "Accommodating discarded jobs in ready queue of core %d\n", core_no);
 
-    for(int i=MAX_CRITICALITY_LEVELS - 1; i >= 0; i--) {
-        prev = dummy_node;
-        curr = (*discarded_queue)->job_list_head;
-        while(curr != NULL)
+    for(int i=task_set->total_levels - 1; i >= 0; i--) {
+        link = &(*discarded_queue)->job_list_head;
+        while(*link != NULL)
         {
+            curr = *link;
             if(task_set->task_list[curr->task_number].criticality_lvl == i && task_set->task_list[curr->task_number].core == core_no)
             {
                 crit_level = task_set->task_list[curr->task_number].criticality_lvl;            
                 rem_exec_time = task_set->task_list[curr->task_number].WCET[crit_level] - (curr->execution_time - curr->rem_exec_time);
-                fprintf(output[core_no], "Discarded job: %d,%d, Exec time: %5lf\n", curr->task_number, curr->job_number, rem_exec_time);
+                TRACE(trace, TRACE_JOBS, "Discarded job: %d,%d, Exec time: %5lf\n", curr->task_number, curr->job_number, TICKS_TO_UNITS(rem_exec_time));
                 
-                max_slack = find_max_slack(task_set, curr_crit_level, core_no, curr->absolute_deadline, curr_time, (*ready_queue));
-                fprintf(output[core_no], "Max slack: %.5lf | ", max_slack);
+                max_slack = find_max_slack(task_set, processor, curr_crit_level, core_no, curr->absolute_deadline, curr_time);
+                TRACE(trace, TRACE_JOBS, "Max slack: %.5lf | ", TICKS_TO_UNITS(max_slack));
 
                 if(max_slack >= rem_exec_time)
                 {
                     ready_job = curr;
-                    prev->next = curr->next;
-                    curr = curr->next;
+                    *link = curr->next;
                     ready_job->next = NULL;
                     (*discarded_queue)->num_jobs--;
-                    fprintf(output[core_no], "Job %d,%d inserted in ready queue of core %d\n", ready_job->task_number, ready_job->job_number, core_no);
+                    //The job can run for the slack it was admitted with, up to the WCET of its own level. The core drops it when its WCET counter runs out.
+                    ready_job->WCET_counter = rem_exec_time;
+                    ready_job->reclaimed_exec_time = ready_job->rem_exec_time;
+                    TRACE(trace, TRACE_JOBS, "Job %d,%d inserted in ready queue of core %d\n", ready_job->task_number, ready_job->job_number, core_no);
                     insert_job_in_ready_queue(ready_queue, ready_job); 
-                    stats->total_discarded_jobs[core_no]++;
+                    processor->stats->total_discarded_jobs[core_no]++;
+                    continue;
                 }
-                else
-                {
-                    prev = curr;
-                    curr = curr->next;
-                }
-            }
-            else
-            {
-                prev = curr;
-                curr = curr->next;
             }
+            link = &curr->next;
         }
 
-        prev = dummy_node;
-        curr = (*discarded_queue)->job_list_head;
-        while(curr != NULL)
+        link = &(*discarded_queue)->job_list_head;
+        while(*link != NULL)
         {
+            curr = *link;
             if(task_set->task_list[curr->task_number].criticality_lvl == i && task_set->task_list[curr->task_number].core != core_no)
             {
                 crit_level = task_set->task_list[curr->task_number].criticality_lvl;            
                 rem_exec_time = task_set->task_list[curr->task_number].WCET[crit_level] - (curr->execution_time - curr->rem_exec_time);
-                fprintf(output[core_no], "Discarded job: %d,%d, Exec time: %5lf\n", curr->task_number, curr->job_number, rem_exec_time);
+                TRACE(trace, TRACE_JOBS, "Discarded job: %d,%d, Exec time: %5lf\n", curr->task_number, curr->job_number, TICKS_TO_UNITS(rem_exec_time));
                 
-                max_slack = find_max_slack(task_set, curr_crit_level, core_no, curr->absolute_deadline, curr_time, (*ready_queue));
-                fprintf(output[core_no], "Max slack: %.5lf | ", max_slack);
+                max_slack = find_max_slack(task_set, processor, curr_crit_level, core_no, curr->absolute_deadline, curr_time);
+                TRACE(trace, TRACE_JOBS, "Max slack: %.5lf | ", TICKS_TO_UNITS(max_slack));
 
-                if(max_slack > rem_exec_time)
+                if(max_slack >= rem_exec_time)
                 {
                     ready_job = curr;
-                    prev->next = curr->next;
-                    curr = curr->next;
+                    *link = curr->next;
                     ready_job->next = NULL;
                     (*discarded_queue)->num_jobs--;
-                    fprintf(output[core_no], "Job %d,%d inserted in ready queue of core %d\n", ready_job->task_number, ready_job->job_number, core_no);
+                    ready_job->WCET_counter = rem_exec_time;
+                    ready_job->reclaimed_exec_time = ready_job->rem_exec_time;
+                    TRACE(trace, TRACE_JOBS, "Job %d,%d migrated to the ready queue of core %d\n", ready_job->task_number, ready_job->job_number, core_no);
                     insert_job_in_ready_queue(ready_queue, ready_job); 
-                    stats->total_discarded_jobs[core_no]++;
-                }
-                else
-                {
-                    prev = curr;
-                    curr = curr->next;
+                    processor->stats->total_discarded_jobs[core_no]++;
+                    processor->stats->total_migrations[core_no]++;
+                    continue;
                 }
             }
-            else
-            {
-                prev = curr;
-                curr = curr->next;
-            }
+            link = &curr->next;
         }
 
     }
 
-    (*discarded_queue)->job_list_head = dummy_node->next;
-    dummy_node->next = NULL;
-    free(dummy_node);
-
     return;
 }
 
+/*
+    Preconditions:
+        Input: {pointer to taskset, pointer to processor, the first core and the core after the last core of the mode switch cluster, the current time}
+                processor->migration == MIGRATION_SEMI_PARTITIONED
+                The cores of the cluster have changed their criticality level at the current time and have no job scheduled, as their ready queues have just been filtered.
+
+    Purpose of the function: Offers the discarded pool to every active core of the cluster in turn, so that the jobs dropped at a criticality change migrate to any of them with enough slack.
+                             The other cores are not at the current time yet, so they take jobs from the pool at their own completion and idle instants (see reclaim_discarded_jobs).
+                             The slack of a core is found at its own criticality level, so a core still in a lower mode counts the demand of its lower criticality tasks.
+                             The pool is locked while a core takes jobs from it.
+
+    Postconditions:
+        Output: {void}
+*/
+void distribute_discarded_jobs(task_set_struct *task_set, processor_struct *processor, int first_core, int last_core, tick_t curr_time)
+{
+    int core_no;
+
+    pthread_mutex_lock(&processor->discarded_lock);
+    for (core_no = first_core; core_no < last_core && processor->discarded_pool->num_jobs > 0; core_no++)
+    {
+        if (processor->cores[core_no].state == ACTIVE)
+            accommodate_discarded_jobs(&processor->cores[core_no].ready_queue, &processor->discarded_pool, task_set, processor, core_no, processor->cores[core_no].crit_level, curr_time);
+    }
+    pthread_mutex_unlock(&processor->discarded_lock);
+}
+
+/*
+    Preconditions:
+        Input: {pointer to taskset, pointer to processor, the core number, the current time}
+                The core is active and has no job scheduled, as at a completion or when it is idle.
+
+    Purpose of the function: Reclaims the slack of the core for the discarded jobs. The jobs of its discarded queue, or of the discarded pool in semi-partitioned mode,
+                             are admitted in the order of accommodate_discarded_jobs while the slack of the core at its criticality level covers them.
+                             The slack left by the jobs that completed under their WCET is part of it, as the demand of the core is found from the remaining WCETs of its jobs.
+                             The slack test assumes the core runs at full speed, so the core is boosted until its ready queue is empty if a job is admitted.
+
+    Postconditions:
+        Output: {void}
+        Result: The admitted jobs are in the ready queue of the core.
+*/
+void reclaim_discarded_jobs(task_set_struct *task_set, processor_struct *processor, int core_no, tick_t curr_time)
+{
+    core_struct *core = &processor->cores[core_no];
+    int num_jobs = core->ready_queue->num_jobs;
+
+    if (processor->migration == MIGRATION_SEMI_PARTITIONED)
+    {
+        pthread_mutex_lock(&processor->discarded_lock);
+        accommodate_discarded_jobs(&core->ready_queue, &processor->discarded_pool, task_set, processor, core_no, core->crit_level, curr_time);
+        pthread_mutex_unlock(&processor->discarded_lock);
+    }
+    else if (core->local_discarded_queue->num_jobs != 0)
+    {
+        accommodate_discarded_jobs(&core->ready_queue, &core->local_discarded_queue, task_set, processor, core_no, core->crit_level, curr_time);
+    }
+
+    if (core->ready_queue->num_jobs != num_jobs)
+    {
+        core->dvfs_boost = 1;
+        update_core_frequency(processor, core_no);
+    }
+}
+
 /*
     Preconditions: 
         Input: {pointer to taskset, pointer to the newly arrived job, the task number of job, the release time of the job, pointer to the core}
@@ -323,13 +736,13 @@ void accommodate_discarded_jobs(job_queue_struct **ready_queue, job_queue_struct
         Output: {void}
         Result: A newly arrived job with all the fields initialized.
 */
-void find_job_parameters(task *task_list, job *new_job, int task_number, int job_number, double release_time, int curr_crit_level)
+void find_job_parameters(task *task_list, job *new_job, int task_number, int job_number, tick_t release_time, int curr_crit_level)
 {
-    double actual_exec_time;
+    tick_t actual_exec_time;
 
     new_job->release_time = release_time;
 
-    actual_exec_time = task_list[task_number].exec_times[job_number];
+    actual_exec_time = find_execution_time(&task_list[task_number], job_number);
 
     new_job->execution_time = actual_exec_time;
     new_job->rem_exec_time = new_job->execution_time;
@@ -337,11 +750,22 @@ void find_job_parameters(task *task_list, job *new_job, int task_number, int job
     new_job->task_number = task_number;
     new_job->absolute_deadline = new_job->release_time + task_list[task_number].virtual_deadline;
     new_job->job_number = job_number;
+    new_job->preemptions = 0;
+    new_job->reclaimed_exec_time = 0;
     new_job->next = NULL;
 
     return;
 }
 
+/*
+    Function to move the task to its next job. The release time is kept up to date with the job number, so it is not found again from the phase at every release.
+*/
+void advance_task_release(task_set_struct *task_set, int num_task)
+{
+    task_set->job_number_table[num_task]++;
+    task_set->release_table[num_task] += task_set->period_table[num_task];
+}
+
 /*
     Preconditions:
         Input: {pointer to job queue, pointer to taskset, pointer to core}
@@ -350,53 +774,74 @@ void find_job_parameters(task *task_list, job *new_job, int task_number, int job
                 core!=NULL
 
     Purpose of the function: This function will insert all the jobs which have arrived at the current time unit in the ready queue. The ready queue is sorted according to the deadlines.
-                             It will also compute the procrastination length which is the minimum of the procrastination intervals of all newly arrived jobs.
+                             If timer_expiry is set, the core is waking up from a shutdown and the jobs which arrived while it was asleep are released together.
+                             The procrastination interval of the core is found separately, once the core is idle (see update_core_shutdown).
     Postconditions: 
-        Output: {Returns the procrastination length to update the core timer}
+        Output: {void}
         Result: An updated ready queue with all the newly arrived jobs inserted in their right positions.
 */
-void update_job_arrivals(job_queue_struct **ready_queue, job_queue_struct **discarded_queue, task_set_struct *task_set, int curr_crit_level, double curr_time, int core_no, core_struct *core, int timer_expiry)
+void update_job_arrivals(job_queue_struct **ready_queue, task_set_struct *task_set, int curr_crit_level, tick_t curr_time, int core_no, core_struct *core, int timer_expiry)
 {
-    int total_tasks = task_set->total_tasks;
+    trace_struct *trace = core->trace;
     task *task_list = task_set->task_list;
-    int curr_task, crit_level;
+    int curr_task, crit_level, i;
+    int num_released = 0;
+    event_struct *event;
     job *new_job;
 
-    fprintf(output[core_no], "INSERTING JOBS IN READY/DISCARDED QUEUE\n");
+    TRACE(trace, TRACE_JOBS, "INSERTING JOBS IN READY/DISCARDED QUEUE\n");
 
-    //Update the job arrivals from highest criticality level to the lowest.
-    for (crit_level = MAX_CRITICALITY_LEVELS - 1; crit_level >= 0; crit_level--)
+    //Take out all the tasks of the core whose next job has been released by now.
+    //The jobs are released from the highest criticality level to the lowest and in task order within a level, so the tasks are sorted on that key once.
+    while ((event = find_min_event(core->arrival_calendar)) != NULL && event->time <= curr_time)
     {
-        for (curr_task = 0; curr_task < total_tasks; curr_task++)
+        curr_task = event->id;
+        core->released_tasks[num_released++] = (task_set->total_levels - 1 - task_list[curr_task].criticality_lvl) * task_set->total_tasks + curr_task;
+        remove_event(core->arrival_calendar, event->id);
+    }
+    qsort((void *)core->released_tasks, num_released, sizeof(int), int_comparator);
+
+    for (i = 0; i < num_released; i++)
+    {
+        curr_task = core->released_tasks[i] % task_set->total_tasks;
+        crit_level = task_list[curr_task].criticality_lvl;
+
+        tick_t release_time = task_set->release_table[curr_task];
+        tick_t deadline = release_time + task_list[curr_task].virtual_deadline;
+
+        while (deadline < curr_time)
         {
-            if (task_list[curr_task].criticality_lvl == crit_level && task_list[curr_task].core == core_no)
-            {
-                double max_exec_time = task_list[curr_task].WCET[curr_crit_level];
-                double release_time = (task_list[curr_task].phase + task_list[curr_task].period * task_list[curr_task].job_number);
-                double deadline = release_time + task_list[curr_task].virtual_deadline;
+            advance_task_release(task_set, curr_task);
+            release_time = task_set->release_table[curr_task];
+            deadline = release_time + task_list[curr_task].virtual_deadline;
+        }
 
-                while (deadline < curr_time)
-                {
-                    task_list[curr_task].job_number++;
-                    release_time = (task_list[curr_task].phase + task_list[curr_task].period * task_list[curr_task].job_number);
-                    deadline = release_time + task_list[curr_task].virtual_deadline;
-                }
+        if (release_time <= curr_time)
+        {
+            new_job = allocate_job(core->job_pool);
+            find_job_parameters(task_list, new_job, curr_task, task_set->job_number_table[curr_task], release_time, curr_crit_level);
 
-                if (release_time <= curr_time)
-                {
-                    new_job = (job *)malloc(sizeof(job));
-                    find_job_parameters(task_list, new_job, curr_task, task_list[curr_task].job_number, release_time, curr_crit_level);
-
-                    fprintf(output[core_no], "Job %d,%d arrived | ", curr_task, task_list[curr_task].job_number);
-                    if (crit_level >= curr_crit_level)
-                    {
-                        fprintf(output[core_no], "Normal job| Exec time: %.5lf | %s\n", new_job->execution_time, (new_job->execution_time > task_set->task_list[curr_task].WCET[curr_crit_level]) ? "More" : "Less");
-                        insert_job_in_ready_queue(ready_queue, new_job);
-                    }
-                    task_list[curr_task].job_number++;
-                }
+            //After a shutdown the job is released when the core wakes up, later than it arrived.
+            if (timer_expiry && release_time < curr_time)
+                TRACE(trace, TRACE_JOBS, "Job %d,%d arrived at %.5lf, deferred by the shutdown | ", curr_task, task_set->job_number_table[curr_task], TICKS_TO_UNITS(release_time));
+            else
+                TRACE(trace, TRACE_JOBS, "Job %d,%d arrived | ", curr_task, task_set->job_number_table[curr_task]);
+            set_dvfs_util(core, &task_list[curr_task], find_release_dvfs_util(&task_list[curr_task], curr_crit_level));
+            if (crit_level >= curr_crit_level)
+            {
+                TRACE(trace, TRACE_JOBS, "Normal job| Exec time: %.5lf | %s\n", TICKS_TO_UNITS(new_job->execution_time), (new_job->execution_time > task_set->task_list[curr_task].WCET[curr_crit_level]) ? "More" : "Less");
+                insert_job_in_ready_queue(ready_queue, new_job);
             }
+            else
+            {
+                //The job is below the current criticality level of the processor, so it is dropped straight away.
+                release_job(core->job_pool, new_job);
+            }
+            advance_task_release(task_set, curr_task);
         }
+
+        //Put the task back in the calendar with the release time of its next job.
+        update_event(core->arrival_calendar, curr_task, task_set->release_table[curr_task]);
     }
 
     return;
@@ -410,16 +855,14 @@ void update_job_arrivals(job_queue_struct **ready_queue, job_queue_struct **disc
 
     Postconditions: 
         Output: void
-        Result: The completed job is freed and the ready queue is updated.
+        Result: The completed job is given back to the job pool and the ready queue is updated.
 */
-void update_job_removal(task_set_struct *taskset, job_queue_struct **ready_queue)
+void update_job_removal(task_set_struct *taskset, job_queue_struct **ready_queue, job_pool_struct *job_pool)
 {
     //Remove the currently executing job from the ready queue.
-    job *completed_job = (*ready_queue)->job_list_head;
-    (*ready_queue)->job_list_head = (*ready_queue)->job_list_head->next;
-    (*ready_queue)->num_jobs--;
+    job *completed_job = remove_min_job_from_ready_queue(ready_queue);
 
-    free(completed_job);
+    release_job(job_pool, completed_job);
 
     return;
 }
@@ -431,6 +874,7 @@ void update_job_removal(task_set_struct *taskset, job_queue_struct **ready_queue
     Purpose of the function: This function will schedule a new job in the core. 
                              The time of scheduling of job and the time at which job will be completed is updated.
                              The WCET counter of job is updated to indicate the time at which the job will cross its WCET.
+                             Both are found from the cycles left to the job at the frequency of the core.
 
     Postconditions:
         Output: {void}
@@ -440,8 +884,8 @@ void schedule_new_job(core_struct *core, job_queue_struct *ready_queue, task_set
 {
     (*core).curr_exec_job = ready_queue->job_list_head;
     (*core).curr_exec_job->scheduled_time = (*core).total_time;
-    (*core).curr_exec_job->completion_time = (*core).total_time + (*core).curr_exec_job->rem_exec_time;
-    (*core).WCET_counter = (*core).curr_exec_job->scheduled_time + (*core).curr_exec_job->WCET_counter;
+    (*core).curr_exec_job->completion_time = (*core).total_time + find_execution_duration((*core).curr_exec_job->rem_exec_time, (*core).frequency);
+    (*core).WCET_counter = (*core).curr_exec_job->scheduled_time + find_execution_duration((*core).curr_exec_job->WCET_counter, (*core).frequency);
 
     return;
 }
\ No newline at end of file
@@ -0,0 +1,486 @@
+#include "functions.h"
+
+/*
+    Function to allocate the given number of empty histograms.
+*/
+histogram_struct *initialize_histograms(int num_histograms)
+{
+    histogram_struct *histograms = (histogram_struct *)calloc(max_int(num_histograms, 1), sizeof(histogram_struct));
+    int i;
+
+    for (i = 0; i < num_histograms; i++)
+    {
+        histograms[i].min = INT64_MAX;
+        histograms[i].max = INT64_MIN;
+    }
+    return histograms;
+}
+
+/*
+    Function to find the bucket of the magnitude of a value in a histogram. The magnitudes below 2 * HISTOGRAM_SUB_BUCKETS have a bucket each,
+    the others are bucketed on their leading HISTOGRAM_SUB_BITS + 1 bits.
+*/
+int find_histogram_magnitude_bucket(uint64_t magnitude)
+{
+    int bits = (magnitude == 0) ? 0 : 64 - __builtin_clzll(magnitude);
+
+    if (bits <= HISTOGRAM_SUB_BITS + 1)
+        return (int)magnitude;
+    return (bits - HISTOGRAM_SUB_BITS) * HISTOGRAM_SUB_BUCKETS + (int)((magnitude >> (bits - HISTOGRAM_SUB_BITS - 1)) & (HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+/*
+    Function to record a value in a histogram. It takes a bit scan and no allocation, so it can be called at every decision point.
+*/
+void record_histogram(histogram_struct *histogram, int64_t value)
+{
+    uint64_t magnitude = (value < 0) ? -(uint64_t)value : (uint64_t)value;
+    int bucket = find_histogram_magnitude_bucket(magnitude);
+
+    histogram->buckets[(value < 0) ? HISTOGRAM_ZERO_BUCKET - bucket : HISTOGRAM_ZERO_BUCKET + bucket]++;
+    histogram->count++;
+    histogram->sum += (double)value;
+    if (value < histogram->min)
+        histogram->min = value;
+    if (value > histogram->max)
+        histogram->max = value;
+}
+
+/*
+    Function to add the values of a histogram to another.
+*/
+void merge_histogram(histogram_struct *to, histogram_struct *from)
+{
+    int i;
+
+    for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        to->buckets[i] += from->buckets[i];
+    }
+    to->count += from->count;
+    to->sum += from->sum;
+    if (from->min < to->min)
+        to->min = from->min;
+    if (from->max > to->max)
+        to->max = from->max;
+}
+
+/*
+    Function to find the smallest and the largest value of a bucket of the histograms. The bounds beyond the range of int64_t are saturated.
+*/
+void find_histogram_bucket_bounds(int bucket, int64_t *low, int64_t *high)
+{
+    int magnitude_bucket = abs(bucket - HISTOGRAM_ZERO_BUCKET);
+    uint64_t smallest, largest;
+    int shift;
+
+    if (magnitude_bucket < 2 * HISTOGRAM_SUB_BUCKETS)
+    {
+        smallest = largest = (uint64_t)magnitude_bucket;
+    }
+    else
+    {
+        shift = magnitude_bucket / HISTOGRAM_SUB_BUCKETS - 1;
+        smallest = (uint64_t)(HISTOGRAM_SUB_BUCKETS + magnitude_bucket % HISTOGRAM_SUB_BUCKETS) << shift;
+        largest = smallest + ((UINT64_C(1) << shift) - 1);
+    }
+
+    if (bucket >= HISTOGRAM_ZERO_BUCKET)
+    {
+        *low = (smallest > INT64_MAX) ? INT64_MAX : (int64_t)smallest;
+        *high = (largest > INT64_MAX) ? INT64_MAX : (int64_t)largest;
+    }
+    else
+    {
+        *low = (largest > INT64_MAX) ? INT64_MIN : -(int64_t)largest;
+        *high = (smallest > INT64_MAX) ? INT64_MIN : -(int64_t)smallest;
+    }
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the histogram, the percentile in [0, 1]}
+                histogram->count > 0
+
+    Purpose of the function: Finds the given percentile of the values of the histogram to the bucket. It is the largest value of the bucket holding the percentile,
+                             bounded by the minimum and maximum of the histogram, so the 0th and 100th percentiles are exact.
+
+    Postconditions:
+        Output: {The percentile}
+*/
+double find_histogram_percentile(histogram_struct *histogram, double percentile)
+{
+    long rank = (long)ceil(percentile * histogram->count);
+    long seen = 0;
+    int64_t low, high;
+    int i;
+
+    if (rank <= 0)
+        return (double)histogram->min;
+
+    for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        seen += histogram->buckets[i];
+        if (seen >= rank)
+            break;
+    }
+    if (i == HISTOGRAM_BUCKETS)
+        return (double)histogram->max;
+
+    find_histogram_bucket_bounds(i, &low, &high);
+    if (high > histogram->max)
+        high = histogram->max;
+    if (high < histogram->min)
+        high = histogram->min;
+    return (double)high;
+}
+
+/*
+    Function to sum the statistics of every core into a statistics struct of one core, the statistics of the whole run.
+*/
+stats_struct *sum_core_stats(stats_struct *stats)
+{
+    stats_struct *total = initialize_stats_struct(1);
+    int i;
+
+    for (i = 0; i < stats->total_cores; i++)
+    {
+        total->total_shutdown_time[0] += stats->total_shutdown_time[i];
+        total->total_idle_energy[0] += stats->total_idle_energy[i];
+        total->total_active_energy[0] += stats->total_active_energy[i];
+        total->total_context_switches[0] += stats->total_context_switches[i];
+        total->total_arrival_points[0] += stats->total_arrival_points[i];
+        total->total_completion_points[0] += stats->total_completion_points[i];
+        total->total_criticality_change_points[0] += stats->total_criticality_change_points[i];
+        total->total_wakeup_points[0] += stats->total_wakeup_points[i];
+        total->total_discarded_jobs[0] += stats->total_discarded_jobs[i];
+        total->total_deadline_misses[0] += stats->total_deadline_misses[i];
+        total->total_frequency_switches[0] += stats->total_frequency_switches[i];
+        total->total_discarded_jobs_executed[0] += stats->total_discarded_jobs_executed[i];
+        total->total_discarded_jobs_available[0] += stats->total_discarded_jobs_available[i];
+        total->total_preemptions[0] += stats->total_preemptions[i];
+        total->total_completed_jobs[0] += stats->total_completed_jobs[i];
+        total->total_migrations[0] += stats->total_migrations[i];
+        merge_histogram(&total->response_time[0], &stats->response_time[i]);
+        merge_histogram(&total->lateness[0], &stats->lateness[i]);
+        merge_histogram(&total->preemptions[0], &stats->preemptions[i]);
+        merge_histogram(&total->queue_depth[0], &stats->queue_depth[i]);
+        merge_histogram(&total->decision_latency[0], &stats->decision_latency[i]);
+    }
+    total->record_latency = stats->record_latency;
+
+    return total;
+}
+
+/*
+    Function to allocate the histograms of each task of the taskset. The tasks are allocated to their cores, whose numbers are kept for the statistics files.
+*/
+void initialize_task_stats(stats_struct *stats, task_set_struct *task_set)
+{
+    int i;
+
+    stats->total_tasks = task_set->total_tasks;
+    stats->task_core = (int *)malloc(sizeof(int) * max_int(task_set->total_tasks, 1));
+    stats->task_criticality_lvl = (int *)malloc(sizeof(int) * max_int(task_set->total_tasks, 1));
+    stats->task_response_time = initialize_histograms(task_set->total_tasks);
+    stats->task_slack = initialize_histograms(task_set->total_tasks);
+    stats->task_tardiness = initialize_histograms(task_set->total_tasks);
+    for (i = 0; i < task_set->total_tasks; i++)
+    {
+        stats->task_core[i] = task_set->task_list[i].core;
+        stats->task_criticality_lvl[i] = task_set->task_list[i].criticality_lvl;
+    }
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the statistics, the core number, pointer to the completed job, the completion time}
+
+    Purpose of the function: Records the completion of a job in the statistics of its core and, if the task statistics are allocated, of its task.
+                             The lateness, slack and tardiness are taken against the absolute deadline of the job, the one its deadline miss is found on.
+
+    Postconditions:
+        Output: {void}
+*/
+void record_job_completion(stats_struct *stats, int core_no, job *completed_job, tick_t completion_time)
+{
+    tick_t response_time = completion_time - completed_job->release_time;
+    tick_t lateness = completion_time - completed_job->absolute_deadline;
+    int task_number = completed_job->task_number;
+
+    stats->total_completed_jobs[core_no]++;
+    record_histogram(&stats->response_time[core_no], response_time);
+    record_histogram(&stats->lateness[core_no], lateness);
+    record_histogram(&stats->preemptions[core_no], completed_job->preemptions);
+
+    if (stats->total_tasks == 0)
+        return;
+    record_histogram(&stats->task_response_time[task_number], response_time);
+    if (lateness <= 0)
+        record_histogram(&stats->task_slack[task_number], -lateness);
+    else
+        record_histogram(&stats->task_tardiness[task_number], lateness);
+}
+
+/*
+    Function to find the format of a statistics file from its name. Files ending in .json are written as JSON, all others as CSV.
+*/
+int find_stats_format(char *file_name)
+{
+    size_t length = strlen(file_name);
+
+    if (length >= 5 && strcmp(file_name + length - 5, ".json") == 0)
+        return STATS_FORMAT_JSON;
+    return STATS_FORMAT_CSV;
+}
+
+/*
+    Function to write a string as a JSON string, escaping the quotes and the backslashes.
+*/
+void write_json_string(FILE *output, char *text)
+{
+    fputc('"', output);
+    for (; text != NULL && *text != '\0'; text++)
+    {
+        if (*text == '"' || *text == '\\')
+            fputc('\\', output);
+        if ((unsigned char)*text >= 0x20)
+            fputc(*text, output);
+    }
+    fputc('"', output);
+}
+
+/*
+    Function to write one metric of the statistics. A CSV metric is a line of the table, a JSON metric a member of the current object.
+*/
+void write_stats_metric(FILE *output, int format, int run, char *core, char *name, double value, int *first)
+{
+    if (format == STATS_FORMAT_CSV)
+        fprintf(output, "%d,%s,%s,%.10g\n", run, core, name, value);
+    else
+        fprintf(output, "%s\"%s\": %.10g", (*first) ? "" : ", ", name, value);
+    *first = 0;
+}
+
+/*
+    Preconditions:
+        Input: {output file, format, run number, core label, name of the histogram, pointer to the histogram, the scale of its values, the unit of the scaled values}
+
+    Purpose of the function: Writes the summary of a histogram: its count, mean, minimum, 50th, 90th and 99th percentiles and maximum, with the values multiplied by the scale.
+                             A CSV row is written for each of them, named <histogram>_<summary>. The JSON object also holds the non-empty buckets as [low, high, count] triples.
+                             An empty histogram only has its count.
+
+    Postconditions:
+        Output: {void}
+*/
+void write_stats_histogram(FILE *output, int format, int run, char *core, char *name, histogram_struct *histogram, double scale, char *unit)
+{
+    char *summaries[] = {"mean", "min", "p50", "p90", "p99", "max"};
+    double values[6];
+    char metric[64];
+    int64_t low, high;
+    int i, first = 0;
+
+    if (histogram->count > 0)
+    {
+        values[0] = histogram->sum / histogram->count * scale;
+        values[1] = histogram->min * scale;
+        values[2] = find_histogram_percentile(histogram, 0.50) * scale;
+        values[3] = find_histogram_percentile(histogram, 0.90) * scale;
+        values[4] = find_histogram_percentile(histogram, 0.99) * scale;
+        values[5] = histogram->max * scale;
+    }
+
+    if (format == STATS_FORMAT_CSV)
+    {
+        snprintf(metric, sizeof(metric), "%s_count", name);
+        write_stats_metric(output, format, run, core, metric, histogram->count, &first);
+        for (i = 0; i < 6 && histogram->count > 0; i++)
+        {
+            snprintf(metric, sizeof(metric), "%s_%s", name, summaries[i]);
+            write_stats_metric(output, format, run, core, metric, values[i], &first);
+        }
+        return;
+    }
+
+    fprintf(output, "\"%s\": {\"unit\": \"%s\", \"count\": %ld", name, unit, histogram->count);
+    for (i = 0; i < 6 && histogram->count > 0; i++)
+    {
+        write_stats_metric(output, format, run, core, summaries[i], values[i], &first);
+    }
+    fprintf(output, ", \"buckets\": [");
+    first = 1;
+    for (i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        if (histogram->buckets[i] == 0)
+            continue;
+        find_histogram_bucket_bounds(i, &low, &high);
+        fprintf(output, "%s[%.10g, %.10g, %ld]", first ? "" : ", ", low * scale, high * scale, histogram->buckets[i]);
+        first = 0;
+    }
+    fprintf(output, "]}");
+}
+
+/*
+    Function to write the counters and the histograms of a core of the statistics. In JSON they are the members of the object of the core.
+*/
+void write_stats_core(FILE *output, int format, int run, char *core, stats_struct *stats, int core_no)
+{
+    char *int_names[] = {"context_switches", "arrival_points", "completion_points", "criticality_change_points", "wakeup_points",
+                         "discarded_jobs", "deadline_misses", "frequency_switches", "preemptions", "completed_jobs", "migrations"};
+    int int_values[] = {stats->total_context_switches[core_no], stats->total_arrival_points[core_no], stats->total_completion_points[core_no],
+                        stats->total_criticality_change_points[core_no], stats->total_wakeup_points[core_no], stats->total_discarded_jobs[core_no],
+                        stats->total_deadline_misses[core_no], stats->total_frequency_switches[core_no], stats->total_preemptions[core_no],
+                        stats->total_completed_jobs[core_no], stats->total_migrations[core_no]};
+    char *double_names[] = {"active_energy", "idle_energy", "shutdown_time", "discarded_jobs_executed", "discarded_jobs_available"};
+    double double_values[] = {stats->total_active_energy[core_no], stats->total_idle_energy[core_no], stats->total_shutdown_time[core_no],
+                              stats->total_discarded_jobs_executed[core_no], stats->total_discarded_jobs_available[core_no]};
+    char *separator = (format == STATS_FORMAT_JSON) ? ", " : "";
+    int i, first = 1;
+
+    if (format == STATS_FORMAT_JSON)
+        fprintf(output, "\"counters\": {");
+    for (i = 0; i < (int)(sizeof(int_values) / sizeof(int_values[0])); i++)
+    {
+        write_stats_metric(output, format, run, core, int_names[i], int_values[i], &first);
+    }
+    for (i = 0; i < (int)(sizeof(double_values) / sizeof(double_values[0])); i++)
+    {
+        write_stats_metric(output, format, run, core, double_names[i], double_values[i], &first);
+    }
+    if (format == STATS_FORMAT_JSON)
+        fprintf(output, "}, \"histograms\": {");
+
+    write_stats_histogram(output, format, run, core, "response_time", &stats->response_time[core_no], 1.00 / TICKS_PER_UNIT, "time");
+    fprintf(output, "%s", separator);
+    write_stats_histogram(output, format, run, core, "lateness", &stats->lateness[core_no], 1.00 / TICKS_PER_UNIT, "time");
+    fprintf(output, "%s", separator);
+    write_stats_histogram(output, format, run, core, "preemptions_per_job", &stats->preemptions[core_no], 1.00, "preemptions");
+    fprintf(output, "%s", separator);
+    write_stats_histogram(output, format, run, core, "queue_depth", &stats->queue_depth[core_no], 1.00, "jobs");
+    if (stats->record_latency)
+    {
+        fprintf(output, "%s", separator);
+        write_stats_histogram(output, format, run, core, "decision_latency", &stats->decision_latency[core_no], 1.00, "ns");
+    }
+    if (format == STATS_FORMAT_JSON)
+        fprintf(output, "}");
+}
+
+/*
+    Function to write the histograms of a task of the statistics. The CSV rows are on the core of the task and their metrics are prefixed with task<number>_.
+*/
+void write_stats_task(FILE *output, int format, int run, stats_struct *stats, int task_number)
+{
+    char *names[] = {"response_time", "slack", "tardiness"};
+    histogram_struct *histograms[] = {&stats->task_response_time[task_number], &stats->task_slack[task_number], &stats->task_tardiness[task_number]};
+    char core[16], name[64];
+    int i;
+
+    snprintf(core, sizeof(core), "%d", stats->task_core[task_number]);
+    if (format == STATS_FORMAT_JSON)
+        fprintf(output, "{\"task\": %d, \"core\": %d, \"criticality_lvl\": %d, \"histograms\": {", task_number, stats->task_core[task_number], stats->task_criticality_lvl[task_number]);
+    for (i = 0; i < 3; i++)
+    {
+        if (format == STATS_FORMAT_CSV)
+            snprintf(name, sizeof(name), "task%d_%s", task_number, names[i]);
+        else
+            snprintf(name, sizeof(name), "%s", names[i]);
+        if (format == STATS_FORMAT_JSON && i > 0)
+            fprintf(output, ", ");
+        write_stats_histogram(output, format, run, core, name, histograms[i], 1.00 / TICKS_PER_UNIT, "time");
+    }
+    if (format == STATS_FORMAT_JSON)
+        fprintf(output, "}}");
+}
+
+/*
+    Function to start a statistics file: the header of the CSV table, or the opening of the list of runs in JSON.
+*/
+void write_stats_header(FILE *output, int format)
+{
+    if (format == STATS_FORMAT_CSV)
+        fprintf(output, "run,core,metric,value\n");
+    else
+        fprintf(output, "{\"ticks_per_unit\": %d, \"runs\": [\n", TICKS_PER_UNIT);
+}
+
+/*
+    Function to end a statistics file.
+*/
+void write_stats_footer(FILE *output, int format)
+{
+    if (format == STATS_FORMAT_JSON)
+        fprintf(output, "\n]}\n");
+}
+
+/*
+    Preconditions:
+        Input: {output file, format, run number, name of the taskset, pointer to the statistics of the run, whether it is the first run of the file}
+                The header of the file is written.
+
+    Purpose of the function: Writes the statistics of one run, for each core, for each task if they were recorded, and for the whole run. The CSV rows of the whole run have the core "all",
+                             and in JSON the run is an object with the lists of its cores and tasks and the sum of the cores as "total".
+                             The times are in time units, and the decision latencies, if recorded, in nanoseconds.
+
+    Postconditions:
+        Output: {void}
+*/
+void write_stats_run(FILE *output, int format, int run, char *taskset, stats_struct *stats, int first)
+{
+    stats_struct *total = sum_core_stats(stats);
+    char core[16];
+    int i;
+
+    if (format == STATS_FORMAT_JSON)
+    {
+        fprintf(output, "%s{\"run\": %d, \"taskset\": ", first ? "" : ",\n", run);
+        write_json_string(output, taskset);
+        fprintf(output, ", \"cores\": [");
+    }
+    for (i = 0; i < stats->total_cores; i++)
+    {
+        snprintf(core, sizeof(core), "%d", i);
+        if (format == STATS_FORMAT_JSON)
+            fprintf(output, "%s\n  {\"core\": %d, ", (i > 0) ? "," : "", i);
+        write_stats_core(output, format, run, core, stats, i);
+        if (format == STATS_FORMAT_JSON)
+            fprintf(output, "}");
+    }
+    if (format == STATS_FORMAT_JSON)
+        fprintf(output, "],\n \"tasks\": [");
+    for (i = 0; i < stats->total_tasks; i++)
+    {
+        if (format == STATS_FORMAT_JSON)
+            fprintf(output, "%s\n  ", (i > 0) ? "," : "");
+        write_stats_task(output, format, run, stats, i);
+    }
+    if (format == STATS_FORMAT_JSON)
+        fprintf(output, "],\n \"total\": {");
+    write_stats_core(output, format, run, "all", total, 0);
+    if (format == STATS_FORMAT_JSON)
+        fprintf(output, "}}");
+
+    free_stats_struct(total);
+}
+
+/*
+    Function to write the statistics of a single simulation to a CSV or JSON file, as the run 0. Returns 0 if the file cannot be opened.
+*/
+int write_stats_file(char *file_name, char *taskset, stats_struct *stats)
+{
+    int format = find_stats_format(file_name);
+    FILE *output = fopen(file_name, "w");
+
+    if (output == NULL)
+    {
+        printf("ERROR: Cannot open statistics file %s\n", file_name);
+        return 0;
+    }
+
+    write_stats_header(output, format);
+    write_stats_run(output, format, 0, taskset, stats, 1);
+    write_stats_footer(output, format);
+    fclose(output);
+    return 1;
+}
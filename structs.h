@@ -7,13 +7,26 @@
 #include <string.h>
 #include <time.h>
 #include <math.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
 
-#define MAX_CRITICALITY_LEVELS 2
+//Time base of the scheduler. All times are integer ticks, TICKS_PER_UNIT ticks to one time unit of the input files (set with -DTICKS_PER_UNIT=...).
+//Integer times make the decision points exact, so that equal times compare equal and the hyperperiod is an exact LCM.
+typedef int64_t tick_t;
+#ifndef TICKS_PER_UNIT
+#define TICKS_PER_UNIT 1000
+#endif
+#define TICK_MAX INT64_MAX
+#define UNITS_TO_TICKS(units) ((tick_t)llround((units) * (double)TICKS_PER_UNIT))
+#define TICKS_TO_UNITS(ticks) ((double)(ticks) / (double)TICKS_PER_UNIT)
+
+//The number of criticality levels of a text taskset whose first line gives only the number of tasks.
+//The number of cores is the number of entries in the cores file, unless given on the command line.
+#define DEFAULT_CRITICALITY_LEVELS 2
 #define LOW 0
 #define HIGH 1
 
-#define NUM_CORES 2
-
 //Decision points
 #define ARRIVAL 0
 #define COMPLETION 1
@@ -38,43 +51,290 @@
 
 #define FREQUENCY_LEVELS 5
 
+//Frequency governors of the cores
+#define DVFS_NONE 0
+#define DVFS_CYCLE_CONSERVING 1
+
+//Allocation of the tasks to the cores. ALLOCATION_FILE takes the mapping and the x factors from the input files, the others partition the tasks with the EDF-VD schedulability test as the admission test.
+#define ALLOCATION_FILE 0
+#define ALLOCATION_FFD 1
+#define ALLOCATION_WFD 2
+#define ALLOCATION_CA_TPA 3
+//Rounding error allowed when the loads of the cores are compared during partitioning.
+#define ALLOCATION_LOAD_TOLERANCE 1e-9
+
+//Where the jobs discarded at a criticality change go. MIGRATION_NONE keeps them in the discarded queue of their core (partitioned EDF-VD).
+//MIGRATION_SEMI_PARTITIONED puts them in a discarded pool shared by the cores, from which they can migrate to any core with enough slack.
+#define MIGRATION_NONE 0
+#define MIGRATION_SEMI_PARTITIONED 1
+
+//Instruction sets of the kernels of the schedulability analysis, in increasing order. The best one the processor supports is selected at runtime.
+#define KERNELS_SCALAR 0
+#define KERNELS_SSE2 1
+#define KERNELS_AVX2 2
+#define KERNEL_SETS 3
+
+//The cores can be simulated on several threads, which only meet when a core can change its criticality level.
+//To find that time the execution times of the next jobs of each task are looked at, up to this many jobs ahead.
+#define PARALLEL_LOOKAHEAD_JOBS 64
+
+//Power of a core executing at frequency f, relative to the power at the maximum frequency. The voltage scales with the frequency, so the dynamic power goes as f^3.
+#define ACTIVE_POWER(f) ((f) * (f) * (f))
+//Rounding error allowed on the sum of the utilisations of a core when its frequency is selected.
+#define DVFS_UTIL_TOLERANCE 1e-9
+
+#define JOB_POOL_SLAB_SIZE 256
+
+#define TASKSET_FILE_MAGIC "MCTS"
+#define TASKSET_FILE_VERSION 1
+
+//Sources of the execution times of the jobs
+#define EXEC_TIME_TRACE 0
+#define EXEC_TIME_MAPPED 1
+#define EXEC_TIME_SAMPLER 2
+#define EXEC_TIME_WCET_FRACTION 3
+
+#define EXEC_TIME_WINDOW 32
+
+//Period distributions of the taskset generator
+#define PERIOD_LOG_UNIFORM 0
+#define PERIOD_HARMONIC 1
+#define GENERATOR_MAX_LEVELS 16
+//The number of times the utilisations of a level are drawn again before a generated taskset is given up, when a task exceeds the maximum utilisation.
+#define GENERATOR_MAX_ATTEMPTS 1000
+//The number of execution times recorded for each generated task when the taskset is written to a file.
+#define GENERATOR_TRACE_JOBS 100
+#define TRACE_BUFFER_SIZE 4096
+
+//Trace levels of the schedule written for each core. A trace statement is compiled only if its level is at most TRACE_MAX_LEVEL (set with -DTRACE_MAX_LEVEL=...),
+//and written only if its level is at most the runtime level of the trace.
+#define TRACE_NONE 0
+#define TRACE_DECISIONS 1
+#define TRACE_JOBS 2
+#define TRACE_VERBOSE 3
+#ifndef TRACE_MAX_LEVEL
+#define TRACE_MAX_LEVEL TRACE_VERBOSE
+#endif
+
+//Trace modes. Text traces are formatted as they are written. Binary traces store the arguments in a ring buffer, which is drained to the file by another thread.
+#define TRACE_TEXT 0
+#define TRACE_BINARY 1
+#define TRACE_RING_SIZE (1 << 16)
+#define TRACE_FORMAT_SLOTS 256
+#define TRACE_MAX_ARGS 16
+#define TRACE_MAX_STRING 255
+#define TRACE_FILE_MAGIC "MCTR"
+#define TRACE_FILE_VERSION 1
+
 /*
-    ADT for a task. The parameters in the task are:
-        phase: The time at which the first job of task arrives.
-        period: The interarrival time of the jobs.
-        relative_deadline: The deadline of each job.
-        criticality_lvl: The criticality level of the job.
-        WCET[MAX_CRITICALITY_LEVELS]: The worst case execution time for each criticality level. 
+    ADT for a buffered input stream. The file is read in chunks of capacity bytes and the numbers are parsed straight from the buffer.
+        lock: Held while a window of execution times is read, as the trace stream is shared by the tasks of the cores simulated on different threads.
+*/
+typedef struct input_stream_struct
+{
+    FILE *fd;
+    char *buffer;
+    size_t capacity;
+    size_t size;
+    size_t pos;
+    pthread_mutex_t lock;
+} input_stream_struct;
+
+/*
+    ADT for the source of the actual execution times of the jobs of a task. The execution time of a job is produced when the job is released.
+        type: EXEC_TIME_TRACE, EXEC_TIME_MAPPED, EXEC_TIME_SAMPLER or EXEC_TIME_WCET_FRACTION.
+        num_exec_times: The length of the recorded trace. Jobs past the end of the trace replay it from the start.
+        exec_times: The mapped trace (EXEC_TIME_MAPPED) or the window of the trace read from the file (EXEC_TIME_TRACE).
+        window_start: The job number of exec_times[0] in the window.
+        window_length: The number of execution times in the window.
+        trace_offset: The offset of the first execution time of the task in the trace file.
+        next_offset: The offset of the execution time of job window_start + window_length in the trace file.
+        trace: The trace file stream, shared by all the tasks. It is read under its lock.
+        seed: The seed of the sampler. The execution time of a job depends only on the seed, the task and the job number.
+        fraction: The fraction of the LO criticality WCET used by the WCET fraction model, and the lower bound of the sampler.
+        overrun_probability: The probability with which the sampler draws an execution time above the LO criticality WCET.
+*/
+typedef struct exec_time_source_struct
+{
+    int type;
+    int num_exec_times;
+    double *exec_times;
+    int window_start;
+    int window_length;
+    long trace_offset;
+    long next_offset;
+    input_stream_struct *trace;
+    uint64_t seed;
+    double fraction;
+    double overrun_probability;
+} exec_time_source_struct;
+
+/*
+    ADT for a task. The release fields of the tasks are in the release tables of the taskset, and the fields read with them come first here. The parameters in the task are:
         virtual_deadline: The virtual deadline calculated for the task. 
-        job_number: The number of jobs released by the task.
-        util: Utilisation of the task at each criticality level.
+        WCET[total_levels]: The worst case execution time for each criticality level. It is the row of the task in the WCET table of the taskset.
+        core: The core the task is allocated to, -1 if it is not allocated.
+        criticality_lvl: The criticality level of the job.
+        task_number: The position of the task in the task list.
+        dvfs_util: The utilisation the frequency governor accounts for the task. It is the WCET over the virtual deadline while a job is pending, and the executed cycles over the virtual deadline after it completes.
+        relative_deadline: The deadline of each job.
+        util: Utilisation of the task at each criticality level. It is the row of the task in the utilisation table of the taskset.
+        exec_source: The source of the actual execution times of the jobs of the task.
 */
 typedef struct task
 {
-    double phase;
-    double period;
-    double relative_deadline;
-    int criticality_lvl;
-    double *WCET;
-    double virtual_deadline;
+    tick_t virtual_deadline;
+    tick_t *WCET;
     int core;
+    int criticality_lvl;
     int task_number;
-    int job_number; //not required
+    double dvfs_util;
+
+    tick_t relative_deadline;
     double *util;
-    double *exec_times;
     int shutdown;
+    exec_time_source_struct exec_source;
 } task;
 
 /*
     ADT for task list. 
         It contains the total tasks and the pointer to the tasks list array.
+        total_levels: The number of criticality levels of the taskset. The WCET and util arrays of the tasks have this many entries.
+        WCET_table, util_table: The WCETs and utilisations of every task at every level, the row of task i at i * total_levels (see sort_taskset).
+                                The WCET and util arrays of the tasks point into them, so the levels of the tasks are read from one block of memory.
+        phase_table, period_table: The time at which the first job of each task arrives and the interarrival time of its jobs.
+        release_table: The release time of the next job of each task, that is phase + period * job number.
+        job_number_table: The number of jobs released by each task.
+                          The release tables are indexed by the task number, so the releases and the scans over the tasks of a core read them without the rest of the tasks.
+        mapped_file: The binary taskset file mapped in memory, if the taskset was read from one. The execution time traces of the tasks point into it.
+        mapped_size: The size of the mapping.
+        exec_trace: The stream of the text trace file, from which the execution times of the tasks are read in windows.
 */
 typedef struct task_set_struct
 {
     int total_tasks;
+    int total_levels;
     task *task_list;
+    tick_t *WCET_table;
+    double *util_table;
+    tick_t *phase_table;
+    tick_t *period_table;
+    tick_t *release_table;
+    int *job_number_table;
+    void *mapped_file;
+    size_t mapped_size;
+    input_stream_struct *exec_trace;
 } task_set_struct;
 
+/*
+    ADT for the names of the input files.
+        taskset_file: The text file with the tasks (input.txt).
+        exec_times_file: The text file with the actual execution times of the jobs (input_times.txt). It is not read if the execution times are generated.
+        allocation_file: The text file with the task to core mapping (input_allocation.txt).
+        binary_file: The binary taskset file. If it is set, the text files are not read.
+        cores_file: The text file with the x factor and criticality threshold of each core (input_cores.txt).
+        generator: The parameters of the taskset generator. If it is set, the taskset is generated and the taskset files are not read.
+*/
+typedef struct input_files_struct
+{
+    char *taskset_file;
+    char *exec_times_file;
+    char *allocation_file;
+    char *binary_file;
+    char *cores_file;
+    struct generator_struct *generator;
+} input_files_struct;
+
+/*
+    ADT for the parameters of the synthetic taskset generator.
+        total_tasks: The number of tasks of each taskset.
+        total_levels: The number of criticality levels.
+        target_util: The target utilisation at each level l of the tasks of criticality at least l, the sum that the feasibility test bounds on one core.
+        criticality_mix: The probability of a task having each criticality level.
+        period_distribution: PERIOD_LOG_UNIFORM draws the periods log-uniformly in [min_period, max_period] and rounds them to a multiple of period_granularity.
+                             PERIOD_HARMONIC draws them among min_period times the powers of 2 up to max_period.
+        max_task_util: The largest utilisation of a task at its criticality level. The utilisations of a level are drawn again if a task exceeds it.
+        seed: The seed of the generator. A taskset depends only on the parameters, the seed and set_number, so the tasksets of a sweep can be generated in any order.
+        set_number: The number of the taskset in the sequence of the seed.
+*/
+typedef struct generator_struct
+{
+    int total_tasks;
+    int total_levels;
+    double target_util[GENERATOR_MAX_LEVELS];
+    double criticality_mix[GENERATOR_MAX_LEVELS];
+    int period_distribution;
+    double min_period;
+    double max_period;
+    double period_granularity;
+    double max_task_util;
+    uint64_t seed;
+    uint64_t set_number;
+} generator_struct;
+
+/*
+    ADT for the options of the simulations given on the command line. In batch mode they apply to every taskset of the batch.
+        total_cores: The number of cores of the processor, 0 to have one core for each entry of the cores file.
+        allocation: How the tasks are allocated to the cores (ALLOCATION_FILE, ALLOCATION_FFD, ALLOCATION_WFD or ALLOCATION_CA_TPA).
+        governor: The frequency governor of the cores.
+        shutdown_threshold: The shortest procrastination interval for which an idle core is shut down, negative to never shut the cores down.
+        exec_time_type: The source of the execution times of the jobs. The seed, fraction and overrun probability are the parameters of the generated sources.
+        continue_on_miss: Keep simulating after a deadline miss instead of ending the simulation.
+        migration: Where the discarded jobs go (MIGRATION_NONE or MIGRATION_SEMI_PARTITIONED).
+        mode_switch_cluster: The number of cores that change their criticality level together, 0 for all the cores of the processor.
+        threads: The number of threads on which the cores of a simulation are run, 1 to take the decision points of the cores one at a time.
+*/
+typedef struct options_struct
+{
+    int total_cores;
+    int allocation;
+    int governor;
+    tick_t shutdown_threshold;
+    int exec_time_type;
+    uint64_t seed;
+    double fraction;
+    double overrun_probability;
+    int continue_on_miss;
+    int migration;
+    int mode_switch_cluster;
+    int threads;
+} options_struct;
+
+/*
+    Header of the binary taskset file. The file is laid out as:
+        header, task records [total_tasks], WCET [total_tasks][total_levels], util [total_tasks][total_levels], execution times [total_exec_times].
+    All values are stored in the byte order of the machine that wrote the file.
+        magic: TASKSET_FILE_MAGIC.
+        version: TASKSET_FILE_VERSION.
+        exec_times_offset: The offset of the execution times in the file.
+*/
+typedef struct taskset_file_header_struct
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t total_tasks;
+    uint32_t total_levels;
+    uint64_t exec_times_offset;
+    uint64_t total_exec_times;
+} taskset_file_header_struct;
+
+/*
+    Record of a task in the binary taskset file.
+        exec_times_index: The index of the first execution time of the task in the execution times array.
+        num_exec_times: The number of execution times of the task.
+*/
+typedef struct taskset_file_task_struct
+{
+    double phase;
+    double relative_deadline;
+    double period;
+    int32_t criticality_lvl;
+    int32_t core;
+    uint64_t exec_times_index;
+    uint32_t num_exec_times;
+    uint32_t reserved;
+} taskset_file_task_struct;
+
 /*
     ADT for a job. The parameters of the job are:
         job_number: The number of job released.
@@ -86,21 +346,31 @@ typedef struct task_set_struct
         completion_time: The time at which the job will finish execution.
         WCET_counter: A counter to check whether the job exceeds the worst case execution time.
         absolute_deadline: The deadline of the job.
-        next: A link to the next job in the array.
+        next: A link to the next job in the discarded queue, or to the next sibling in the ready queue.
+        child: The leftmost child of the job in the ready queue.
+        prev: The parent of the job if it is the leftmost child in the ready queue, else its previous sibling.
+        queue_order: The order in which the job was inserted in the ready queue. Jobs with equal deadlines are served in this order.
+        preemptions: The number of times the job was preempted.
+        reclaimed_exec_time: The remaining execution time of the job when it was last taken back from a discarded queue, 0 if it is not a reclaimed job.
 
 */
 struct job
 {
-    double release_time;
-    double execution_time;
-    double absolute_deadline;
-    double scheduled_time;
-    double rem_exec_time;
-    double completion_time;
-    double WCET_counter;
+    tick_t release_time;
+    tick_t execution_time;
+    tick_t absolute_deadline;
+    tick_t scheduled_time;
+    tick_t rem_exec_time;
+    tick_t completion_time;
+    tick_t WCET_counter;
     int job_number;
     int task_number;
     struct job *next; 
+    struct job *child;
+    struct job *prev;
+    unsigned long queue_order;
+    int preemptions;
+    tick_t reclaimed_exec_time;
 };
 
 typedef struct job job;
@@ -108,13 +378,124 @@ typedef struct job job;
 /*
     ADT for job queue. 
         It contains the total number of jobs in ready queue and pointer to the ready queue.
+        The ready queue is a pairing heap ordered on the absolute deadline. job_list_head is the root of the heap, that is, the job with the earliest deadline.
+        The discarded queue is a linked list sorted on the criticality level and the deadline.
+        num_inserted: The number of jobs inserted in the queue so far. It is used to order the jobs with equal deadlines.
+        slack_cache: The slack cache kept up to date with the jobs of the queue, NULL for the discarded queues.
 */
 typedef struct job_queue_struct
 {
     int num_jobs;
     job *job_list_head;
+    unsigned long num_inserted;
+    struct slack_cache_struct *slack_cache;
 } job_queue_struct;
 
+/*
+    ADT for the slack cache of a core. It holds the demand of the ready queue of the core, so that the slack up to any deadline takes O(log n) time.
+    Once built, it follows the ready queue job by job, and only the sums from the position of the job that changed are found again.
+        valid: Whether the cache holds the jobs of the ready queue. It is cleared when the deadlines of the queue change at a criticality change.
+        time: The time at which the densities were found.
+        task_list: The tasks of the jobs, to find their remaining WCETs.
+        jobs: The (deadline, remaining WCET) pairs of the jobs in the ready queue, sorted on the deadline.
+        entries: entries[i] is the job of the ith pair.
+        prefix_demand: prefix_demand[i] is the sum of the remaining WCETs of the first i jobs.
+        density: density[i] is the remaining WCET / (deadline - time) of the ith job, 0 if it is due by the time.
+        suffix_density: suffix_density[i] is the sum of the densities of the jobs from i on.
+*/
+typedef struct slack_cache_struct
+{
+    int valid;
+    tick_t time;
+    task *task_list;
+    int num_jobs;
+    int capacity;
+    double *jobs;
+    job **entries;
+    double *prefix_demand;
+    double *density;
+    double *suffix_density;
+} slack_cache_struct;
+
+/*
+    ADT for the job pool of a core. Jobs are allocated in slabs and recycled through a freelist, so that no malloc is needed per job release.
+        free_jobs: The list of free jobs, linked through next.
+        slabs: The slabs of JOB_POOL_SLAB_SIZE jobs allocated by the pool.
+        num_slabs: The number of slabs allocated.
+        max_slabs: The size of the slabs array.
+*/
+typedef struct job_pool_struct
+{
+    job *free_jobs;
+    job **slabs;
+    int num_slabs;
+    int max_slabs;
+} job_pool_struct;
+
+/*
+    ADT for an event in the event calendar.
+        time: The time at which the event occurs.
+        id: The task (arrival calendar of a core) or the core (event calendar of the processor) the event belongs to.
+*/
+typedef struct event_struct
+{
+    tick_t time;
+    int id;
+} event_struct;
+
+/*
+    ADT for the event calendar. It is an indexed binary min-heap of events ordered on time, ties broken on the id.
+        num_events: The number of events in the heap.
+        capacity: The maximum number of events in the heap.
+        events: The heap array.
+        position: position[id] is the slot of the event of that id in the heap, -1 if it is not present.
+*/
+typedef struct event_heap_struct
+{
+    int num_events;
+    int capacity;
+    event_struct *events;
+    int *position;
+} event_heap_struct;
+
+/*
+    ADT for a format string of the trace.
+        format: The format string, as passed to the trace. Format strings are interned on their address, so each call site is parsed once.
+        id: The id of the format in the binary trace.
+        num_args: The number of arguments of the format.
+        arg_types: The type of each argument: 'i' for int, 'l' for long, 'f' for double and 's' for string.
+*/
+typedef struct trace_format_struct
+{
+    const char *format;
+    int id;
+    int num_args;
+    char arg_types[TRACE_MAX_ARGS];
+} trace_format_struct;
+
+/*
+    ADT for the trace of a core.
+        level: The runtime trace level. Statements above it are skipped without evaluating their arguments.
+        mode: TRACE_TEXT or TRACE_BINARY.
+        output: The file to which the trace is written.
+        ring: The ring buffer of a binary trace. It is a single producer (the scheduler) single consumer (the drain thread) queue, so head and tail are the only shared state.
+        head, tail: Byte counters of the producer and the consumer. The ring holds head - tail bytes.
+        drained: 1 while a drain thread empties the ring. Otherwise the scheduler drains the ring itself when it is full.
+        formats: Hash table of the interned format strings.
+*/
+typedef struct trace_struct
+{
+    int level;
+    int mode;
+    FILE *output;
+    char *ring;
+    atomic_size_t head;
+    atomic_size_t tail;
+    atomic_int drained;
+    trace_format_struct *formats;
+    int num_formats;
+} trace_struct;
+
 /*
     ADT for the core. The parameters for the core are:
         ready_queue: The ready queue of the core.
@@ -122,51 +503,222 @@ typedef struct job_queue_struct
         total_time: The total time for which the core has run.
         total_idle_time: The total time for which the core was idle.
         WCET_counter: The WCET counter of the currently executing job.
-        frequency: The frequency at which core is running.
+        frequency: The frequency at which core is running. The times of the jobs are in cycles at the maximum frequency, so a job with c cycles left runs for c / frequency ticks.
+        dvfs_util: The sum of the dvfs_util of the tasks of the core. The governor runs the core at the lowest frequency at least this high.
+        dvfs_boost: Set at a criticality change and when the core wakes up from a shutdown. The core runs at the maximum frequency until its ready queue is empty.
         state: The current state of core. (ACTIVE or SHUTDOWN)
         next_invocation_time: The countdown timer for core. The core will wakeup after timer expires.
         x_factor: The factor to be used while calculating virtual deadlines.
         threshold_crit_lvl: The threshold level aboe which all tasks are considered as HI criticality and below which all tasks are considered as LO criticality.
-        rem_util: The remaining utilisation of core. This is needed to check whether additional tasks can be allocated to this core.
+        crit_level: The current criticality level of the core. It is the same for all the cores of a mode switch cluster of the processor.
+        rem_util: The remaining utilisation of the core at each criticality level, which is 1 minus the utilisation at that level of the tasks of at least that criticality.
+        utilisation: The utilisation matrix of the tasks of the core. utilisation[l * total_levels + k] is the utilisation at level k of the tasks of criticality level l.
+                     It and rem_util are kept by add_task_to_core and remove_task_from_core, so the schedulability of the core is checked without scanning the taskset.
         completed_scheduling: Flag to indicate whether this core has completed its hyperperiod.
         is_shutdown: SHUTDOWN or NON-SHUTDOWN core.
         num_tasks_allocated: The number of tasks allocated to that core.
+        arrival_calendar: Heap of the tasks of the core keyed on the release time of their next job.
+        released_tasks: Scratch array used to collect the tasks releasing a job at the current decision point.
+        task_index, level_index: The tasks of the core sorted on their criticality level and then their number (see initialize_task_index).
+                                 The tasks of level l are task_index[level_index[l]] to task_index[level_index[l + 1] - 1], so the tasks of at least level l run to level_index[total_levels].
+        job_pool: The pool from which the jobs released on the core are allocated.
+        trace: The trace to which the schedule of the core is written.
+        slack_cache: The demand of the ready queue, used to find the slack for discarded jobs.
 */
 typedef struct core_struct
 {
     job_queue_struct *ready_queue;
     job_queue_struct *local_discarded_queue;
     job *curr_exec_job;
+    int crit_level;
 
-    double total_time;
-    double total_idle_time;
-    double WCET_counter;
-    double next_invocation_time;
+    tick_t total_time;
+    tick_t total_idle_time;
+    tick_t WCET_counter;
+    tick_t next_invocation_time;
 
     double frequency;
+    double dvfs_util;
+    int dvfs_boost;
     int state; //ACTIVE or SHUTDOWN
     double *rem_util;
+    double *utilisation;
 
     double x_factor;
     int threshold_crit_lvl;
     int is_shutdown;
+    int num_tasks_allocated;
+
+    event_heap_struct *arrival_calendar;
+    int *released_tasks;
+    int *task_index;
+    int *level_index;
+    job_pool_struct *job_pool;
+    trace_struct *trace;
+    slack_cache_struct *slack_cache;
 
 } core_struct;
 
+//Buckets of the histograms of the statistics. As in an HDR histogram, each power of two is split into HISTOGRAM_SUB_BUCKETS buckets of equal width,
+//so a value is recorded to within 1 / HISTOGRAM_SUB_BUCKETS of itself with one bit scan, and the values below 2 * HISTOGRAM_SUB_BUCKETS exactly.
+//Bucket HISTOGRAM_ZERO_BUCKET holds 0, the positive values are above it and the negative values mirrored below it.
+#define HISTOGRAM_SUB_BITS 3
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_ZERO_BUCKET ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS - 1)
+#define HISTOGRAM_BUCKETS (2 * HISTOGRAM_ZERO_BUCKET + 1)
+
+//Formats of the statistics files, chosen from the extension of the file name.
+#define STATS_FORMAT_CSV 0
+#define STATS_FORMAT_JSON 1
+
+/*
+    ADT for a histogram of the statistics. The count, sum, minimum and maximum are exact, and the percentiles are found to the bucket.
+*/
+typedef struct histogram_struct
+{
+    long count;
+    double sum;
+    int64_t min;
+    int64_t max;
+    long buckets[HISTOGRAM_BUCKETS];
+} histogram_struct;
+
+/*
+    ADT for the statistics of a simulation. Each array has one entry per core. Times and energies are in time units, not ticks.
+    The active energy is the time spent executing weighted with ACTIVE_POWER of the frequency of the core.
+        total_preemptions: The number of times a job was preempted by the arrival of a job with an earlier deadline.
+        total_completed_jobs: The number of jobs that completed their execution.
+        total_migrations: The number of discarded jobs of the tasks of other cores accommodated in the ready queue of the core.
+        response_time, lateness: Histograms of the completion time of the jobs less their release time and less their absolute deadline, in ticks.
+                                 The absolute deadline is the one the job was scheduled on, that is the virtual deadline of a HI job released in LO mode.
+        preemptions: Histogram of the number of preemptions of each completed job.
+        queue_depth: Histogram of the number of jobs in the ready queue of the decision core after each decision point.
+        decision_latency: Histogram of the wall-clock time taken by each decision point of the core in nanoseconds. It is recorded only if record_latency is set.
+        total_tasks: The number of tasks with statistics, 0 unless record_tasks is set. The task histograms are then allocated when the scheduling starts.
+        task_core, task_criticality_lvl: The core and the criticality level of each task.
+        task_response_time, task_slack, task_tardiness: Histograms of each task of the response time of its jobs, and of the time from their completion to their absolute deadline
+                                                        if they met it, or from their absolute deadline to their completion if they missed it, in ticks.
+*/
+typedef struct stats_struct
+{
+    int total_cores;
+    int record_latency;
+    double *total_shutdown_time;
+    double *total_idle_energy;
+    double *total_active_energy;
+    int *total_context_switches;
+    int *total_arrival_points;
+    int *total_completion_points;
+    int *total_criticality_change_points;
+    int *total_wakeup_points;
+    int *total_discarded_jobs;
+    int *total_deadline_misses;
+    int *total_frequency_switches;
+    double *total_discarded_jobs_executed;
+    double *total_discarded_jobs_available;
+    int *total_preemptions;
+    int *total_completed_jobs;
+    int *total_migrations;
+    histogram_struct *response_time;
+    histogram_struct *lateness;
+    histogram_struct *preemptions;
+    histogram_struct *queue_depth;
+    histogram_struct *decision_latency;
+    int record_tasks;
+    int total_tasks;
+    int *task_core;
+    int *task_criticality_lvl;
+    histogram_struct *task_response_time;
+    histogram_struct *task_slack;
+    histogram_struct *task_tardiness;
+} stats_struct;
+
 /*
     ADT for the processor. 
         total_cores: Total number of cores in the processor.
-        crit_level: The current criticality level of the processor.
+        total_levels: The number of criticality levels of the taskset running on the processor.
+        crit_level: The highest criticality level of the cores.
+        mode_switch_cluster: The number of cores that change their criticality level together. Core c is in the cluster c / mode_switch_cluster.
+                             0 puts all the cores in one cluster, so that an overrun raises the level of every core, 1 gives each core its own criticality mode.
+        governor: The frequency governor of the cores (DVFS_NONE or DVFS_CYCLE_CONSERVING).
+        shutdown_threshold: The shortest procrastination interval for which an idle core is shut down. Negative if the cores are never shut down.
+        allocation: How the tasks are allocated to the cores (ALLOCATION_FILE, ALLOCATION_FFD, ALLOCATION_WFD or ALLOCATION_CA_TPA).
+        continue_on_miss: Keep simulating after a deadline miss instead of ending the simulation.
+        migration: Where the discarded jobs go (MIGRATION_NONE or MIGRATION_SEMI_PARTITIONED).
+        discarded_pool: The discarded jobs of every core in semi-partitioned mode, sorted on the criticality level and the deadline as the local discarded queues.
+        discarded_lock: The lock of the discarded pool. The pool is only accessed with it held, so that cores can take jobs from it concurrently.
+        threads: The number of threads on which the cores are run (see run_parallel_epoch). With 1 the decision points of the cores are taken one at a time.
         cores: List of core structs.
+        event_calendar: Heap of the cores keyed on the time of their next decision point.
+        arrival_position: The position array shared by the arrival calendars of the cores.
+        output_file: The output file of the simulation.
+        trace_drainer: The thread draining the binary traces of the cores, if trace_draining is set.
+        stats: The statistics of the simulation.
+    The processor holds all the state of one simulation, so that several simulations can run at the same time.
 */
 
 typedef struct processor_struct
 {
     int total_cores;
+    int total_levels;
     int crit_level;
+    int mode_switch_cluster;
+    int governor;
+    tick_t shutdown_threshold;
+    int allocation;
+    int continue_on_miss;
+    int migration;
+    job_queue_struct *discarded_pool;
+    pthread_mutex_t discarded_lock;
+    int threads;
     core_struct *cores;
+    event_heap_struct *event_calendar;
+    int *arrival_position;
+    FILE *output_file;
+    stats_struct *stats;
+    pthread_t trace_drainer;
+    atomic_int trace_draining;
 } processor_struct;
 
+/*
+    ADT for a thread of the parallel simulation: the simulation it belongs to and its number.
+*/
+typedef struct parallel_worker_struct
+{
+    struct parallel_struct *parallel;
+    int thread_number;
+    pthread_t thread;
+} parallel_worker_struct;
+
+/*
+    ADT for the parallel simulation of the cores of a processor. The cores are split over the threads, thread i running the cores i, i + num_threads, ...
+    The threads and the scheduler meet at the start and at the end of each epoch, in which every core takes its decision points before epoch_end.
+        task_set, processor: What the decision points of the cores are taken on.
+        num_threads, workers: The threads of the simulation.
+        start, end: The barriers at the start and at the end of the epochs, shared by the threads and the scheduler.
+        epoch_end: The end of the current epoch. No core can change its criticality level before it, so the cores do not affect each other within the epoch.
+        done: Set when the simulation is over, so that the threads exit at the start of the next epoch.
+        sync_time: The earliest time at which each core can change its criticality level (see find_core_sync_time).
+        missed: Set for a core whose simulation ended at a deadline miss in the epoch.
+        overrun_job, overrun_level: For each task, the first job from its next release whose execution time exceeds the WCET of the task at overrun_level,
+                                    or the job at which the lookahead stopped.
+*/
+typedef struct parallel_struct
+{
+    task_set_struct *task_set;
+    processor_struct *processor;
+    int num_threads;
+    parallel_worker_struct *workers;
+    pthread_barrier_t start;
+    pthread_barrier_t end;
+    tick_t epoch_end;
+    int done;
+    tick_t *sync_time;
+    int *missed;
+    int *overrun_job;
+    int *overrun_level;
+} parallel_struct;
+
 /*
     ADT for the decision point:
         It contains the type of decision point (ARRIVAL or COMPLETION or TIMER_EXPIRE_ERR or CRIT_CHANGE), the decision time and the core for which decision has to be taken.
@@ -174,7 +726,7 @@ typedef struct processor_struct
 typedef struct decision_struct
 {
     int core_no;
-    double decision_time;
+    tick_t decision_time;
     int decision_point;
 } decision_struct;
 
@@ -184,32 +736,50 @@ typedef struct x_factor_struct
     int k;
 } x_factor_struct;
  
-typedef struct stats_struct
-{
-    double *total_shutdown_time;
-    double *total_idle_energy;
-    double *total_active_energy;
-    int *total_context_switches;
-    int *total_arrival_points;
-    int *total_completion_points;
-    int *total_criticality_change_points;
-    int *total_wakeup_points;
-    int *total_discarded_jobs;
-    double *total_discarded_jobs_executed;
-    double *total_discarded_jobs_available;
-} stats_struct;
 
+
+/*
+    ADT for a future job considered by the procrastination of a core: its task, its absolute deadline and its WCET.
+*/
 typedef struct la_edf_struct
 {
     int task_number;
-    double deadline;
-    double exec_time;
+    tick_t deadline;
+    tick_t exec_time;
 }la_edf_struct;
 
-FILE *output_file;
-FILE *output[NUM_CORES];
-stats_struct *stats;
+/*
+    ADT for a task in the order of the task list: its period and its number before the sort.
+*/
+typedef struct task_order_struct
+{
+    tick_t period;
+    int task_number;
+} task_order_struct;
+
+/*
+    ADT for a task in the order in which the tasks are partitioned: its number, its criticality level and its utilisation at that level.
+*/
+typedef struct allocation_order_struct
+{
+    int task_number;
+    int criticality_lvl;
+    double util;
+} allocation_order_struct;
+
+/*
+    ADT for the kernels of the schedulability analysis of one instruction set. Every set gives the same results to the bit, as each element is computed in the same order.
+        name: The name of the instruction set.
+        add_rows: Adds the rows of the table listed in rows, of row_length entries each, to sum.
+        find_demand_densities: Finds the demand density remaining WCET / (deadline - curr_time) of each (deadline, remaining WCET) pair of jobs, 0 if the deadline is not after curr_time.
+*/
+typedef struct kernel_struct
+{
+    char *name;
+    void (*add_rows)(double *sum, const double *table, const int *rows, int num_rows, int row_length);
+    void (*find_demand_densities)(double *density, const double *jobs, int num_jobs, double curr_time);
+} kernel_struct;
 
-double frequency[FREQUENCY_LEVELS];
+extern double frequency[FREQUENCY_LEVELS];
 
 #endif
\ No newline at end of file
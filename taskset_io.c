@@ -0,0 +1,728 @@
+#include "functions.h"
+
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define INPUT_BUFFER_SIZE 65536
+#define MAX_TOKEN_LENGTH 64
+
+input_stream_struct *open_input_stream(char *filename, size_t capacity)
+{
+    input_stream_struct *stream;
+    FILE *fd = fopen(filename, "r");
+
+    if (fd == NULL)
+        return NULL;
+
+    stream = (input_stream_struct *)malloc(sizeof(input_stream_struct));
+    stream->fd = fd;
+    stream->buffer = (char *)malloc(capacity);
+    stream->capacity = capacity;
+    stream->size = 0;
+    stream->pos = 0;
+    pthread_mutex_init(&stream->lock, NULL);
+
+    return stream;
+}
+
+void close_input_stream(input_stream_struct *stream)
+{
+    if (stream == NULL)
+        return;
+    fclose(stream->fd);
+    pthread_mutex_destroy(&stream->lock);
+    free(stream->buffer);
+    free(stream);
+}
+
+/*
+    Function to get the next character of the stream without consuming it. Returns EOF at the end of the file.
+*/
+int peek_input_stream(input_stream_struct *stream)
+{
+    if (stream->pos == stream->size)
+    {
+        stream->size = fread(stream->buffer, 1, stream->capacity, stream->fd);
+        stream->pos = 0;
+        if (stream->size == 0)
+            return EOF;
+    }
+    return (unsigned char)stream->buffer[stream->pos];
+}
+
+/*
+    Function to read the next whitespace separated token of the stream. Returns 0 at the end of the file.
+*/
+int read_token(input_stream_struct *stream, char *token)
+{
+    int c, length = 0;
+
+    while ((c = peek_input_stream(stream)) != EOF && (c == ' ' || c == '\t' || c == '\n' || c == '\r'))
+        stream->pos++;
+
+    while ((c = peek_input_stream(stream)) != EOF && c != ' ' && c != '\t' && c != '\n' && c != '\r')
+    {
+        if (length < MAX_TOKEN_LENGTH - 1)
+            token[length++] = (char)c;
+        stream->pos++;
+    }
+    token[length] = '\0';
+
+    return length > 0;
+}
+
+int read_double(input_stream_struct *stream, double *value)
+{
+    char token[MAX_TOKEN_LENGTH];
+    char *end;
+
+    if (!read_token(stream, token))
+        return 0;
+    *value = strtod(token, &end);
+    return *end == '\0';
+}
+
+/*
+    Function to get the offset in the file of the next unread character of the stream.
+*/
+long tell_input_stream(input_stream_struct *stream)
+{
+    return ftell(stream->fd) - (long)(stream->size - stream->pos);
+}
+
+/*
+    Function to move the stream to the given offset of the file.
+*/
+void seek_input_stream(input_stream_struct *stream, long offset)
+{
+    fseek(stream->fd, offset, SEEK_SET);
+    stream->size = 0;
+    stream->pos = 0;
+}
+
+int read_int(input_stream_struct *stream, int *value)
+{
+    char token[MAX_TOKEN_LENGTH];
+    char *end;
+
+    if (!read_token(stream, token))
+        return 0;
+    *value = (int)strtol(token, &end, 10);
+    return *end == '\0';
+}
+
+/*
+    Function to read an optional integer from the rest of the current line. Returns 0, without consuming the line break, if the line has no more tokens.
+*/
+int read_int_on_line(input_stream_struct *stream, int *value)
+{
+    int c;
+
+    while ((c = peek_input_stream(stream)) != EOF && (c == ' ' || c == '\t' || c == '\r'))
+        stream->pos++;
+    if (c == EOF || c == '\n')
+        return 0;
+    return read_int(stream, value);
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the input file names}
+                input_files->taskset_file!=NULL
+
+    Purpose of the function: Reads the taskset from the text input files (the formats are described in the README).
+                             The tasks are returned in the order of the input file. The execution times are not read here, they are read in windows from the trace file when the jobs are released.
+                             If no execution times file is given, the execution times have to be generated by setting another source with set_exec_time_source.
+                             If no allocation file is given, the tasks are left unallocated for the tasks to be partitioned onto the cores.
+
+    Postconditions:
+        Output: {Pointer to the structure of taskset created, NULL if a file is missing or malformed}
+*/
+task_set_struct *read_text_taskset(input_files_struct *input_files)
+{
+    input_stream_struct *input, *exec = NULL, *allocation = NULL;
+    task_set_struct *task_set = NULL;
+    char token[MAX_TOKEN_LENGTH];
+    int num_task, criticality_lvl, tasks, levels, i;
+    int *cores;
+    int valid = 1;
+
+    input = open_input_stream(input_files->taskset_file, INPUT_BUFFER_SIZE);
+    if (input_files->allocation_file != NULL)
+        allocation = open_input_stream(input_files->allocation_file, INPUT_BUFFER_SIZE);
+    if (input_files->exec_times_file != NULL)
+        exec = open_input_stream(input_files->exec_times_file, INPUT_BUFFER_SIZE);
+
+    if (input == NULL || (input_files->allocation_file != NULL && allocation == NULL) || (input_files->exec_times_file != NULL && exec == NULL))
+    {
+        printf("ERROR: Cannot open input files %s, %s and %s\n", input_files->taskset_file, (input_files->exec_times_file != NULL) ? input_files->exec_times_file : "-", (input_files->allocation_file != NULL) ? input_files->allocation_file : "-");
+        close_input_stream(input);
+        close_input_stream(exec);
+        close_input_stream(allocation);
+        return NULL;
+    }
+
+    task_set = (task_set_struct *)malloc(sizeof(task_set_struct));
+    task_set->mapped_file = NULL;
+    task_set->mapped_size = 0;
+    task_set->exec_trace = NULL;
+
+    //Number of task_list
+    if (!read_int(input, &tasks) || tasks < 0)
+    {
+        printf("ERROR: Cannot read the number of tasks from %s\n", input_files->taskset_file);
+        tasks = 0;
+        valid = 0;
+    }
+    //The first line may also give the number of criticality levels.
+    levels = DEFAULT_CRITICALITY_LEVELS;
+    if (valid && read_int_on_line(input, &levels) && levels <= 0)
+    {
+        printf("ERROR: Invalid number of criticality levels in %s\n", input_files->taskset_file);
+        valid = 0;
+    }
+    allocate_task_tables(task_set, tasks, levels);
+
+    //The allocation file maps each task to a core. Tasks missing from the file are left unallocated.
+    cores = (int *)malloc(sizeof(int) * max_int(tasks, 1));
+    for (i = 0; i < tasks; i++)
+    {
+        cores[i] = -1;
+    }
+    for (i = 0; i < tasks && valid && allocation != NULL; i++)
+    {
+        int task, core;
+        if (!read_int(allocation, &task) || !read_int(allocation, &core))
+            break;
+        if (task >= 0 && task < tasks)
+            cores[task] = core;
+    }
+
+    for (num_task = 0; num_task < tasks && valid; num_task++)
+    {
+        task *curr_task = &task_set->task_list[num_task];
+        double phase = 0, deadline = 0, WCET = 0;
+
+        //The times are given in time units and are kept in ticks.
+        valid = read_double(input, &phase) && read_double(input, &deadline) && read_int(input, &curr_task->criticality_lvl) &&
+                curr_task->criticality_lvl >= 0 && curr_task->criticality_lvl < levels && UNITS_TO_TICKS(deadline) > 0;
+
+        //As it is an implicit-deadline taskset, period = deadline.
+        task_set->phase_table[num_task] = UNITS_TO_TICKS(phase);
+        task_set->release_table[num_task] = task_set->phase_table[num_task];
+        curr_task->relative_deadline = UNITS_TO_TICKS(deadline);
+        task_set->period_table[num_task] = curr_task->relative_deadline;
+        curr_task->util = task_set->util_table + num_task * levels;
+        curr_task->core = cores[num_task];
+        curr_task->WCET = task_set->WCET_table + num_task * levels;
+
+        for (criticality_lvl = 0; criticality_lvl < levels && valid; criticality_lvl++)
+        {
+            valid = read_double(input, &WCET);
+            curr_task->WCET[criticality_lvl] = UNITS_TO_TICKS(WCET);
+            curr_task->util[criticality_lvl] = WCET / deadline;
+        }
+
+        //Only the position of the execution times of the task in the trace file is noted here. They are read in windows as the jobs are released.
+        memset(&curr_task->exec_source, 0, sizeof(exec_time_source_struct));
+        curr_task->exec_source.type = EXEC_TIME_TRACE;
+        if (exec != NULL && valid)
+        {
+            int num_jobs = 0;
+            if (!read_int(exec, &num_jobs) || num_jobs < 0)
+                num_jobs = 0;
+            curr_task->exec_source.num_exec_times = num_jobs;
+            curr_task->exec_source.trace_offset = tell_input_stream(exec);
+            curr_task->exec_source.next_offset = curr_task->exec_source.trace_offset;
+            for (i = 0; i < num_jobs && valid; i++)
+            {
+                valid = read_token(exec, token);
+            }
+        }
+
+        if (!valid)
+        {
+            printf("ERROR: Malformed input for task %d\n", num_task);
+        }
+    }
+
+    free(cores);
+    close_input_stream(input);
+    close_input_stream(exec);
+    close_input_stream(allocation);
+
+    //The execution time sources of the tasks after the malformed one are not set, so only the tables are freed.
+    if (!valid)
+    {
+        free_task_tables(task_set);
+        free(task_set);
+        return NULL;
+    }
+
+    //The trace file is kept open with a small buffer for reading the windows of execution times.
+    if (input_files->exec_times_file != NULL)
+    {
+        task_set->exec_trace = open_input_stream(input_files->exec_times_file, TRACE_BUFFER_SIZE);
+        for (num_task = 0; num_task < tasks; num_task++)
+        {
+            task_set->task_list[num_task].exec_source.trace = task_set->exec_trace;
+        }
+    }
+
+    return task_set;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the execution time source of a task, the job number}
+                exec_source->type == EXEC_TIME_TRACE
+
+    Purpose of the function: Reads the next window of EXEC_TIME_WINDOW execution times of the task, starting from the given job, from the trace file.
+                             Jobs are released in increasing order, so the window only moves forward, except when the trace is replayed from the start.
+                             The stream is seeked to the position of the task for every window, so the windows of the tasks can be read in any order.
+                             The tasks share the stream, so it is locked while the window is read, as the cores can release jobs on different threads.
+
+    Postconditions:
+        Output: {1 if the execution time of the job is in the window, 0 if it cannot be read}
+*/
+int read_exec_time_window(exec_time_source_struct *exec_source, int job_number)
+{
+    int result;
+
+    if (exec_source->trace == NULL)
+        return 0;
+
+    pthread_mutex_lock(&exec_source->trace->lock);
+    result = fill_exec_time_window(exec_source, job_number);
+    pthread_mutex_unlock(&exec_source->trace->lock);
+
+    return result;
+}
+
+/*
+    Function to read the window of execution times of the task starting from the given job, with the trace stream locked. See read_exec_time_window.
+*/
+int fill_exec_time_window(exec_time_source_struct *exec_source, int job_number)
+{
+    char token[MAX_TOKEN_LENGTH];
+    int next_job = exec_source->window_start + exec_source->window_length;
+
+    if (exec_source->exec_times == NULL)
+        exec_source->exec_times = (double *)malloc(sizeof(double) * EXEC_TIME_WINDOW);
+
+    //Start again from the beginning of the trace of the task.
+    if (job_number < exec_source->window_start)
+    {
+        next_job = 0;
+        exec_source->next_offset = exec_source->trace_offset;
+    }
+
+    seek_input_stream(exec_source->trace, exec_source->next_offset);
+
+    //Skip the execution times of the jobs that were never released.
+    while (next_job < job_number)
+    {
+        if (!read_token(exec_source->trace, token))
+            return 0;
+        next_job++;
+    }
+
+    exec_source->window_start = job_number;
+    exec_source->window_length = 0;
+    while (exec_source->window_length < EXEC_TIME_WINDOW && job_number + exec_source->window_length < exec_source->num_exec_times)
+    {
+        if (!read_double(exec_source->trace, &exec_source->exec_times[exec_source->window_length]))
+            break;
+        exec_source->window_length++;
+    }
+    exec_source->next_offset = tell_input_stream(exec_source->trace);
+
+    return exec_source->window_length > 0;
+}
+
+/*
+    Preconditions:
+        Input: {name of the binary taskset file}
+
+    Purpose of the function: Maps the binary taskset file in memory and creates the taskset from it.
+                             The task headers are copied, as the scheduler updates them, and their times are converted to ticks.
+                             The WCETs (in ticks) and the utilisations are copied into the WCET and utilisation tables of the taskset, and the phases and periods into its release tables.
+                             The execution time arrays of the tasks point into the mapped file, so they are not copied.
+
+    Postconditions:
+        Output: {Pointer to the structure of taskset created, NULL if the file cannot be mapped or is not a valid taskset file}
+*/
+task_set_struct *read_binary_taskset(char *filename)
+{
+    struct stat file_stat;
+    taskset_file_header_struct *header;
+    taskset_file_task_struct *records;
+    task_set_struct *task_set;
+    double *WCET, *util, *exec_times;
+    size_t tasks, levels, expected_size;
+    char *mapped;
+    int fd, num_task;
+
+    fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        printf("ERROR: Cannot open binary taskset %s\n", filename);
+        return NULL;
+    }
+
+    if (fstat(fd, &file_stat) < 0 || (size_t)file_stat.st_size < sizeof(taskset_file_header_struct))
+    {
+        printf("ERROR: %s is not a taskset file\n", filename);
+        close(fd);
+        return NULL;
+    }
+
+    mapped = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        printf("ERROR: Cannot map binary taskset %s\n", filename);
+        return NULL;
+    }
+
+    header = (taskset_file_header_struct *)mapped;
+    tasks = header->total_tasks;
+    levels = header->total_levels;
+    expected_size = header->exec_times_offset + sizeof(double) * header->total_exec_times;
+
+    if (memcmp(header->magic, TASKSET_FILE_MAGIC, 4) != 0 || header->version != TASKSET_FILE_VERSION || levels == 0 ||
+        header->exec_times_offset != sizeof(taskset_file_header_struct) + tasks * (sizeof(taskset_file_task_struct) + 2 * levels * sizeof(double)) ||
+        expected_size > (size_t)file_stat.st_size)
+    {
+        printf("ERROR: %s is not a version %d taskset file\n", filename, TASKSET_FILE_VERSION);
+        munmap(mapped, file_stat.st_size);
+        return NULL;
+    }
+
+    records = (taskset_file_task_struct *)(mapped + sizeof(taskset_file_header_struct));
+    WCET = (double *)(records + tasks);
+    util = WCET + tasks * levels;
+    exec_times = (double *)(mapped + header->exec_times_offset);
+
+    task_set = (task_set_struct *)malloc(sizeof(task_set_struct));
+    allocate_task_tables(task_set, tasks, levels);
+    task_set->mapped_file = mapped;
+    task_set->mapped_size = file_stat.st_size;
+    task_set->exec_trace = NULL;
+
+    for (num_task = 0; num_task < (int)tasks; num_task++)
+    {
+        task *curr_task = &task_set->task_list[num_task];
+
+        task_set->phase_table[num_task] = UNITS_TO_TICKS(records[num_task].phase);
+        task_set->release_table[num_task] = task_set->phase_table[num_task];
+        curr_task->relative_deadline = UNITS_TO_TICKS(records[num_task].relative_deadline);
+        task_set->period_table[num_task] = UNITS_TO_TICKS(records[num_task].period);
+        curr_task->criticality_lvl = records[num_task].criticality_lvl;
+        curr_task->core = records[num_task].core;
+        curr_task->WCET = task_set->WCET_table + num_task * levels;
+        curr_task->util = task_set->util_table + num_task * levels;
+        for (size_t level = 0; level < levels; level++)
+        {
+            curr_task->WCET[level] = UNITS_TO_TICKS(WCET[num_task * levels + level]);
+            curr_task->util[level] = util[num_task * levels + level];
+        }
+
+        if (task_set->period_table[num_task] <= 0)
+        {
+            printf("ERROR: Task %d of %s has a period shorter than a tick\n", num_task, filename);
+            free_taskset(task_set);
+            return NULL;
+        }
+
+        if (curr_task->criticality_lvl < 0 || curr_task->criticality_lvl >= (int)levels)
+        {
+            printf("ERROR: Task %d of %s has criticality level %d, but the taskset has %d levels\n", num_task, filename, curr_task->criticality_lvl, (int)levels);
+            free_taskset(task_set);
+            return NULL;
+        }
+
+        memset(&curr_task->exec_source, 0, sizeof(exec_time_source_struct));
+        curr_task->exec_source.type = EXEC_TIME_MAPPED;
+        if (records[num_task].exec_times_index + records[num_task].num_exec_times <= header->total_exec_times)
+        {
+            curr_task->exec_source.exec_times = exec_times + records[num_task].exec_times_index;
+            curr_task->exec_source.num_exec_times = records[num_task].num_exec_times;
+        }
+    }
+
+    return task_set;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to taskset, name of the binary file}
+                task_set!=NULL
+
+    Purpose of the function: Writes the taskset in the binary taskset format, so that it can later be mapped by read_binary_taskset.
+                             The layout is: header, task records, WCET[task][level], util[task][level], execution times of all tasks.
+
+    Postconditions:
+        Output: {1 on success, 0 if the file cannot be written}
+*/
+int write_binary_taskset(task_set_struct *task_set, char *filename)
+{
+    taskset_file_header_struct header;
+    taskset_file_task_struct record;
+    size_t tasks = task_set->total_tasks;
+    uint64_t exec_times_index = 0;
+    int num_task, written = 1;
+    FILE *fd;
+
+    fd = fopen(filename, "wb");
+    if (fd == NULL)
+    {
+        printf("ERROR: Cannot open %s for writing\n", filename);
+        return 0;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TASKSET_FILE_MAGIC, 4);
+    header.version = TASKSET_FILE_VERSION;
+    header.total_tasks = tasks;
+    header.total_levels = task_set->total_levels;
+    header.exec_times_offset = sizeof(taskset_file_header_struct) + tasks * (sizeof(taskset_file_task_struct) + 2 * task_set->total_levels * sizeof(double));
+    header.total_exec_times = 0;
+    for (num_task = 0; num_task < (int)tasks; num_task++)
+    {
+        header.total_exec_times += task_set->task_list[num_task].exec_source.num_exec_times;
+    }
+    written &= fwrite(&header, sizeof(header), 1, fd) == 1;
+
+    for (num_task = 0; num_task < (int)tasks; num_task++)
+    {
+        task *curr_task = &task_set->task_list[num_task];
+
+        memset(&record, 0, sizeof(record));
+        record.phase = TICKS_TO_UNITS(task_set->phase_table[num_task]);
+        record.relative_deadline = TICKS_TO_UNITS(curr_task->relative_deadline);
+        record.period = TICKS_TO_UNITS(task_set->period_table[num_task]);
+        record.criticality_lvl = curr_task->criticality_lvl;
+        record.core = curr_task->core;
+        record.exec_times_index = exec_times_index;
+        record.num_exec_times = curr_task->exec_source.num_exec_times;
+        exec_times_index += curr_task->exec_source.num_exec_times;
+
+        written &= fwrite(&record, sizeof(record), 1, fd) == 1;
+    }
+
+    for (num_task = 0; num_task < (int)tasks; num_task++)
+    {
+        for (int level = 0; level < task_set->total_levels; level++)
+        {
+            double WCET = TICKS_TO_UNITS(task_set->task_list[num_task].WCET[level]);
+            written &= fwrite(&WCET, sizeof(double), 1, fd) == 1;
+        }
+    }
+    for (num_task = 0; num_task < (int)tasks; num_task++)
+    {
+        written &= fwrite(task_set->task_list[num_task].util, sizeof(double), task_set->total_levels, fd) == (size_t)task_set->total_levels;
+    }
+    //The traces are copied through the execution time sources, so a text trace is streamed window by window.
+    for (num_task = 0; num_task < (int)tasks; num_task++)
+    {
+        task *curr_task = &task_set->task_list[num_task];
+        for (int job_number = 0; job_number < curr_task->exec_source.num_exec_times; job_number++)
+        {
+            double exec_time = TICKS_TO_UNITS(find_execution_time(curr_task, job_number));
+            written &= fwrite(&exec_time, sizeof(double), 1, fd) == 1;
+        }
+    }
+
+    if (fclose(fd) != 0 || !written)
+    {
+        printf("ERROR: Cannot write the binary taskset %s\n", filename);
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to taskset, pointer to the input file names}
+                input_files->taskset_file!=NULL
+
+    Purpose of the function: Writes the taskset to the text taskset file and, if it is given, the execution times of the jobs to the text trace file, in the formats read by read_text_taskset.
+                             The trace of each task has the length of its execution time source, so a generated taskset gets its sampled execution times and a read one gets its trace.
+                             The times are written in time units.
+
+    Postconditions:
+        Output: {1 on success, 0 if a file cannot be written}
+*/
+int write_text_taskset(task_set_struct *task_set, input_files_struct *input_files)
+{
+    FILE *input, *exec = NULL;
+    int num_task, level, job_number, written = 1;
+
+    input = fopen(input_files->taskset_file, "w");
+    if (input_files->exec_times_file != NULL)
+        exec = fopen(input_files->exec_times_file, "w");
+    if (input == NULL || (input_files->exec_times_file != NULL && exec == NULL))
+    {
+        printf("ERROR: Cannot open %s for writing\n", (input == NULL) ? input_files->taskset_file : input_files->exec_times_file);
+        if (input != NULL)
+            fclose(input);
+        return 0;
+    }
+
+    written &= fprintf(input, "%d %d\n", task_set->total_tasks, task_set->total_levels) > 0;
+    for (num_task = 0; num_task < task_set->total_tasks; num_task++)
+    {
+        task *curr_task = &task_set->task_list[num_task];
+
+        written &= fprintf(input, "%.12g %.12g %d", TICKS_TO_UNITS(task_set->phase_table[num_task]), TICKS_TO_UNITS(curr_task->relative_deadline), curr_task->criticality_lvl) > 0;
+        for (level = 0; level < task_set->total_levels; level++)
+        {
+            written &= fprintf(input, " %.12g", TICKS_TO_UNITS(curr_task->WCET[level])) > 0;
+        }
+        written &= fprintf(input, "\n") > 0;
+
+        if (exec != NULL)
+        {
+            written &= fprintf(exec, "%d", curr_task->exec_source.num_exec_times) > 0;
+            for (job_number = 0; job_number < curr_task->exec_source.num_exec_times; job_number++)
+            {
+                written &= fprintf(exec, " %.12g", TICKS_TO_UNITS(find_execution_time(curr_task, job_number))) > 0;
+            }
+            written &= fprintf(exec, "\n") > 0;
+        }
+    }
+
+    if (exec != NULL && fclose(exec) != 0)
+        written = 0;
+    if (fclose(input) != 0 || !written)
+    {
+        printf("ERROR: Cannot write the text taskset %s\n", input_files->taskset_file);
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to taskset}
+                The WCET and util arrays of the tasks point into the WCET and utilisation tables of the taskset, in any order.
+
+    Purpose of the function: Sorts the tasks on their periods, the tasks of equal periods keeping their order, and numbers them in that order.
+                             The order is found on an array of keys, so that each task is moved once instead of at every swap of the sort.
+                             The release tables, the WCETs and the utilisations are then copied into new tables in the order of the tasks, so that the row of task i is at i * total_levels.
+
+    Postconditions:
+        Output: {void}
+        Result: The task list is sorted and the tables of the taskset follow its order.
+*/
+void sort_taskset(task_set_struct *task_set)
+{
+    int total_tasks = task_set->total_tasks, total_levels = task_set->total_levels;
+    task_order_struct *order = (task_order_struct *)malloc(sizeof(task_order_struct) * max_int(total_tasks, 1));
+    task_set_struct sorted;
+    int i, from, level;
+
+    for (i = 0; i < total_tasks; i++)
+    {
+        order[i].period = task_set->period_table[i];
+        order[i].task_number = i;
+    }
+    qsort((void *)order, total_tasks, sizeof(task_order_struct), task_order_comparator);
+
+    allocate_task_tables(&sorted, total_tasks, total_levels);
+    for (i = 0; i < total_tasks; i++)
+    {
+        from = order[i].task_number;
+        sorted.task_list[i] = task_set->task_list[from];
+        sorted.task_list[i].task_number = i;
+        sorted.phase_table[i] = task_set->phase_table[from];
+        sorted.period_table[i] = task_set->period_table[from];
+        sorted.release_table[i] = task_set->release_table[from];
+        sorted.job_number_table[i] = task_set->job_number_table[from];
+        for (level = 0; level < total_levels; level++)
+        {
+            sorted.WCET_table[i * total_levels + level] = task_set->WCET_table[from * total_levels + level];
+            sorted.util_table[i * total_levels + level] = task_set->util_table[from * total_levels + level];
+        }
+        sorted.task_list[i].WCET = sorted.WCET_table + i * total_levels;
+        sorted.task_list[i].util = sorted.util_table + i * total_levels;
+    }
+
+    free_task_tables(task_set);
+    task_set->task_list = sorted.task_list;
+    task_set->WCET_table = sorted.WCET_table;
+    task_set->util_table = sorted.util_table;
+    task_set->phase_table = sorted.phase_table;
+    task_set->period_table = sorted.period_table;
+    task_set->release_table = sorted.release_table;
+    task_set->job_number_table = sorted.job_number_table;
+    free(order);
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the taskset, the number of tasks, the number of criticality levels}
+
+    Purpose of the function: Allocates the task list and the tables of the taskset for the given number of tasks and levels, and sets its size.
+                             The tasks have released no job yet. The WCET and util arrays of the tasks are pointed into the tables by the caller.
+
+    Postconditions:
+        Output: {void}
+*/
+void allocate_task_tables(task_set_struct *task_set, int tasks, int levels)
+{
+    task_set->total_tasks = tasks;
+    task_set->total_levels = levels;
+    task_set->task_list = (task *)malloc(sizeof(task) * max_int(tasks, 1));
+    task_set->WCET_table = (tick_t *)malloc(sizeof(tick_t) * max_int(tasks * levels, 1));
+    task_set->util_table = (double *)malloc(sizeof(double) * max_int(tasks * levels, 1));
+    task_set->phase_table = (tick_t *)calloc(max_int(tasks, 1), sizeof(tick_t));
+    task_set->period_table = (tick_t *)calloc(max_int(tasks, 1), sizeof(tick_t));
+    task_set->release_table = (tick_t *)calloc(max_int(tasks, 1), sizeof(tick_t));
+    task_set->job_number_table = (int *)calloc(max_int(tasks, 1), sizeof(int));
+}
+
+/*
+    Function to free the task list and the tables of the taskset.
+*/
+void free_task_tables(task_set_struct *task_set)
+{
+    free(task_set->task_list);
+    free(task_set->WCET_table);
+    free(task_set->util_table);
+    free(task_set->phase_table);
+    free(task_set->period_table);
+    free(task_set->release_table);
+    free(task_set->job_number_table);
+}
+
+/*
+    Function to free the taskset. The arrays of a taskset read from a binary file are released by unmapping the file.
+*/
+void free_taskset(task_set_struct *task_set)
+{
+    int i;
+
+    if (task_set == NULL)
+        return;
+
+    for (i = 0; i < task_set->total_tasks; i++)
+    {
+        task *curr_task = &task_set->task_list[i];
+
+        //For a text taskset, exec_times is the window of the trace read from the file.
+        if (task_set->mapped_file == NULL)
+            free(curr_task->exec_source.exec_times);
+    }
+
+    if (task_set->mapped_file != NULL)
+        munmap(task_set->mapped_file, task_set->mapped_size);
+    close_input_stream(task_set->exec_trace);
+    free_task_tables(task_set);
+    free(task_set);
+}
@@ -0,0 +1,539 @@
+#include "functions.h"
+
+#include <sched.h>
+#include <stdarg.h>
+
+//Marker of a record that defines a format string in the binary trace, in place of a format id.
+#define TRACE_FORMAT_DEFINITION 0xFFFF
+
+/*
+    Function to parse the conversions of a format string. The type of each argument is stored in arg_types.
+    Returns the number of arguments, or -1 if the format has more than TRACE_MAX_ARGS arguments or an unsupported conversion.
+*/
+int parse_trace_format(const char *format, char *arg_types)
+{
+    int num_args = 0, is_long;
+    const char *c = format;
+
+    while (*c != '\0')
+    {
+        if (*c++ != '%')
+            continue;
+        if (*c == '%')
+        {
+            c++;
+            continue;
+        }
+
+        //Skip the flags, width and precision.
+        while (*c != '\0' && strchr("-+ #0123456789.", *c) != NULL)
+            c++;
+        is_long = 0;
+        while (*c == 'l' || *c == 'h')
+            is_long |= (*c++ == 'l');
+
+        if (num_args == TRACE_MAX_ARGS)
+            return -1;
+        switch (*c)
+        {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'x':
+        case 'c':
+            arg_types[num_args++] = is_long ? 'l' : 'i';
+            break;
+        case 'f':
+        case 'e':
+        case 'g':
+            arg_types[num_args++] = 'f';
+            break;
+        case 's':
+            arg_types[num_args++] = 's';
+            break;
+        default:
+            return -1;
+        }
+        c++;
+    }
+
+    return num_args;
+}
+
+/*
+    Preconditions:
+        Input: {file to which the trace is written, runtime trace level, trace mode}
+
+    Purpose of the function: Creates the trace of a core, which takes over the file (NULL for no trace). A text trace formats each statement straight into the file.
+                             A binary trace writes the file header here and then only copies the arguments of each statement into a ring buffer.
+                             The formatting is done offline by decode_trace.
+
+    Postconditions:
+        Output: {Pointer to the trace}
+*/
+trace_struct *initialize_trace(FILE *output, int level, int mode)
+{
+    trace_struct *trace = (trace_struct *)malloc(sizeof(trace_struct));
+    uint32_t version = TRACE_FILE_VERSION;
+
+    trace->level = (output == NULL) ? TRACE_NONE : level;
+    trace->mode = mode;
+    trace->output = output;
+    trace->ring = NULL;
+    trace->formats = NULL;
+    trace->num_formats = 0;
+    atomic_init(&trace->head, 0);
+    atomic_init(&trace->tail, 0);
+    atomic_init(&trace->drained, 0);
+
+    if (mode == TRACE_BINARY && trace->level > TRACE_NONE)
+    {
+        trace->ring = (char *)malloc(TRACE_RING_SIZE);
+        trace->formats = (trace_format_struct *)calloc(TRACE_FORMAT_SLOTS, sizeof(trace_format_struct));
+        fwrite(TRACE_FILE_MAGIC, 1, 4, output);
+        fwrite(&version, sizeof(version), 1, output);
+    }
+
+    return trace;
+}
+
+/*
+    Function to write the bytes in the ring to the file. Only the consumer of the ring (the drain thread, or the scheduler when no drain thread is running) calls it.
+    Returns the number of bytes written.
+*/
+size_t drain_trace(trace_struct *trace)
+{
+    size_t tail = atomic_load_explicit(&trace->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&trace->head, memory_order_acquire);
+    size_t start = tail & (TRACE_RING_SIZE - 1);
+    size_t length = head - tail;
+
+    if (length == 0)
+        return 0;
+
+    //The bytes may wrap around the end of the ring.
+    if (start + length > TRACE_RING_SIZE)
+    {
+        fwrite(trace->ring + start, 1, TRACE_RING_SIZE - start, trace->output);
+        fwrite(trace->ring, 1, start + length - TRACE_RING_SIZE, trace->output);
+    }
+    else
+    {
+        fwrite(trace->ring + start, 1, length, trace->output);
+    }
+
+    atomic_store_explicit(&trace->tail, head, memory_order_release);
+    return length;
+}
+
+/*
+    Function to make room for size bytes in the ring. If a drain thread is running the scheduler waits for it, else it drains the ring itself.
+*/
+void reserve_trace(trace_struct *trace, size_t size)
+{
+    size_t head = atomic_load_explicit(&trace->head, memory_order_relaxed);
+
+    while (head + size - atomic_load_explicit(&trace->tail, memory_order_acquire) > TRACE_RING_SIZE)
+    {
+        if (atomic_load_explicit(&trace->drained, memory_order_acquire))
+            sched_yield();
+        else
+            drain_trace(trace);
+    }
+}
+
+/*
+    Function to copy bytes at the given producer position of the ring, wrapping around its end.
+*/
+void copy_to_trace(trace_struct *trace, size_t position, const void *data, size_t size)
+{
+    size_t start = position & (TRACE_RING_SIZE - 1);
+
+    if (start + size > TRACE_RING_SIZE)
+    {
+        memcpy(trace->ring + start, data, TRACE_RING_SIZE - start);
+        memcpy(trace->ring, (const char *)data + (TRACE_RING_SIZE - start), start + size - TRACE_RING_SIZE);
+    }
+    else
+    {
+        memcpy(trace->ring + start, data, size);
+    }
+}
+
+/*
+    Function to find the interned format of a format string. A format seen for the first time is parsed, and its definition is written to the ring before its first record.
+    Returns NULL if the format cannot be traced in binary form.
+*/
+trace_format_struct *intern_trace_format(trace_struct *trace, const char *format)
+{
+    char record[4 + 2 + TRACE_MAX_STRING * 4];
+    uintptr_t slot = ((uintptr_t)format >> 3) & (TRACE_FORMAT_SLOTS - 1);
+    trace_format_struct *entry;
+    uint16_t marker = TRACE_FORMAT_DEFINITION, id, length;
+    size_t head;
+
+    while (trace->formats[slot].format != NULL && trace->formats[slot].format != format)
+        slot = (slot + 1) & (TRACE_FORMAT_SLOTS - 1);
+
+    entry = &trace->formats[slot];
+    if (entry->format != NULL)
+        return (entry->num_args < 0) ? NULL : entry;
+
+    if (trace->num_formats == TRACE_FORMAT_SLOTS - 1 || strlen(format) > sizeof(record) - 6)
+        return NULL;
+
+    entry->format = format;
+    entry->num_args = parse_trace_format(format, entry->arg_types);
+    if (entry->num_args < 0)
+    {
+        printf("ERROR: Cannot trace format \"%s\" in binary form\n", format);
+        return NULL;
+    }
+    entry->id = trace->num_formats++;
+
+    id = entry->id;
+    length = strlen(format);
+    memcpy(record, &marker, 2);
+    memcpy(record + 2, &id, 2);
+    memcpy(record + 4, &length, 2);
+    memcpy(record + 6, format, length);
+
+    reserve_trace(trace, 6 + length);
+    head = atomic_load_explicit(&trace->head, memory_order_relaxed);
+    copy_to_trace(trace, head, record, 6 + length);
+    atomic_store_explicit(&trace->head, head + 6 + length, memory_order_release);
+
+    return entry;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the trace, format string, arguments of the format}
+                The format is a string literal, as binary traces intern it on its address.
+
+    Purpose of the function: Writes a trace statement. It is called through the TRACE macro, which has already checked the level.
+                             In binary mode the record is the format id followed by the raw arguments, so no formatting is done on the hot path.
+
+    Postconditions:
+        Output: {void}
+*/
+void trace_write(trace_struct *trace, const char *format, ...)
+{
+    char record[2 + TRACE_MAX_ARGS * (1 + TRACE_MAX_STRING)];
+    trace_format_struct *entry;
+    size_t size = 2, head;
+    uint16_t id;
+    va_list args;
+    int i;
+
+    va_start(args, format);
+    if (trace->mode == TRACE_TEXT)
+    {
+        vfprintf(trace->output, format, args);
+        va_end(args);
+        return;
+    }
+
+    entry = intern_trace_format(trace, format);
+    if (entry == NULL)
+    {
+        va_end(args);
+        return;
+    }
+
+    id = entry->id;
+    memcpy(record, &id, 2);
+    for (i = 0; i < entry->num_args; i++)
+    {
+        switch (entry->arg_types[i])
+        {
+        case 'i':
+        {
+            int32_t value = va_arg(args, int);
+            memcpy(record + size, &value, sizeof(value));
+            size += sizeof(value);
+            break;
+        }
+        case 'l':
+        {
+            int64_t value = va_arg(args, long);
+            memcpy(record + size, &value, sizeof(value));
+            size += sizeof(value);
+            break;
+        }
+        case 'f':
+        {
+            double value = va_arg(args, double);
+            memcpy(record + size, &value, sizeof(value));
+            size += sizeof(value);
+            break;
+        }
+        case 's':
+        {
+            const char *value = va_arg(args, const char *);
+            size_t length = strlen(value);
+            if (length > TRACE_MAX_STRING)
+                length = TRACE_MAX_STRING;
+            record[size++] = (char)length;
+            memcpy(record + size, value, length);
+            size += length;
+            break;
+        }
+        }
+    }
+    va_end(args);
+
+    reserve_trace(trace, size);
+    head = atomic_load_explicit(&trace->head, memory_order_relaxed);
+    copy_to_trace(trace, head, record, size);
+    atomic_store_explicit(&trace->head, head + size, memory_order_release);
+}
+
+/*
+    Function to trace a list of jobs, one statement per job.
+*/
+void trace_job_list(trace_struct *trace, int level, job *job_list_head)
+{
+    job *job_temp = job_list_head;
+
+    while (job_temp != NULL)
+    {
+        TRACE(trace, level, "Job:: Task no: %d  Release time: %.2lf  Exec time: %.2lf  Rem Exec time: %.2lf  WCET_counter: %.2lf  Deadline: %.2lf\n",
+              job_temp->task_number,
+              TICKS_TO_UNITS(job_temp->release_time),
+              TICKS_TO_UNITS(job_temp->execution_time),
+              TICKS_TO_UNITS(job_temp->rem_exec_time),
+              TICKS_TO_UNITS(job_temp->WCET_counter),
+              TICKS_TO_UNITS(job_temp->absolute_deadline));
+        job_temp = next_job_in_queue(job_temp);
+    }
+}
+
+/*
+    Function run by the drain thread. It empties the rings of all the cores until the scheduler stops it.
+*/
+void *trace_drain_worker(void *argument)
+{
+    processor_struct *processor = (processor_struct *)argument;
+    struct timespec pause = {0, 100000};
+    size_t drained;
+    int i;
+
+    while (1)
+    {
+        int running = atomic_load_explicit(&processor->trace_draining, memory_order_acquire);
+
+        drained = 0;
+        for (i = 0; i < processor->total_cores; i++)
+        {
+            if (processor->cores[i].trace->ring != NULL)
+                drained += drain_trace(processor->cores[i].trace);
+        }
+
+        //Stop only after a full pass with nothing left, so that the records written before the stop are not lost.
+        if (!running && drained == 0)
+            break;
+        if (drained == 0)
+            nanosleep(&pause, NULL);
+    }
+
+    return NULL;
+}
+
+/*
+    Preconditions:
+        Input: {pointer to the processor}
+                The traces of the cores are initialized.
+
+    Purpose of the function: Starts a thread that drains the binary traces of the cores while the scheduler runs. Nothing is started if no core has a binary trace.
+
+    Postconditions:
+        Output: {void}
+*/
+void start_trace_drain(processor_struct *processor)
+{
+    int i, binary = 0;
+
+    for (i = 0; i < processor->total_cores; i++)
+    {
+        binary |= (processor->cores[i].trace->ring != NULL);
+    }
+    atomic_store(&processor->trace_draining, 0);
+    if (!binary)
+        return;
+
+    for (i = 0; i < processor->total_cores; i++)
+    {
+        atomic_store(&processor->cores[i].trace->drained, 1);
+    }
+    atomic_store(&processor->trace_draining, 1);
+    pthread_create(&processor->trace_drainer, NULL, trace_drain_worker, processor);
+}
+
+/*
+    Function to stop the drain thread once it has written all the records. The scheduler drains the rings itself afterwards.
+*/
+void stop_trace_drain(processor_struct *processor)
+{
+    int i;
+
+    if (!atomic_load(&processor->trace_draining))
+        return;
+
+    atomic_store(&processor->trace_draining, 0);
+    pthread_join(processor->trace_drainer, NULL);
+    for (i = 0; i < processor->total_cores; i++)
+    {
+        atomic_store(&processor->cores[i].trace->drained, 0);
+    }
+}
+
+/*
+    Function to write what is left in the ring, close the file of the trace and free the trace.
+*/
+void free_trace(trace_struct *trace)
+{
+    if (trace == NULL)
+        return;
+    if (trace->ring != NULL)
+        drain_trace(trace);
+    if (trace->output != NULL)
+        fclose(trace->output);
+    free(trace->ring);
+    free(trace->formats);
+    free(trace);
+}
+
+/*
+    Preconditions:
+        Input: {name of the binary trace file, file to which the text is written}
+
+    Purpose of the function: Decodes a binary trace to the text that a text trace of the same level would have written.
+                             Each record is formatted by walking its format string and printing one conversion at a time with its argument.
+
+    Postconditions:
+        Output: {0 on success, 1 if the file cannot be read or is not a trace file}
+*/
+int decode_trace(char *trace_file, FILE *output)
+{
+    char *formats[TRACE_FORMAT_SLOTS] = {NULL};
+    char magic[4], spec[32], string[TRACE_MAX_STRING + 1];
+    char arg_types[TRACE_MAX_ARGS];
+    uint32_t version;
+    uint16_t id, length;
+    FILE *fd;
+    int valid = 1, i;
+
+    fd = fopen(trace_file, "rb");
+    if (fd == NULL)
+    {
+        printf("ERROR: Cannot open trace file %s\n", trace_file);
+        return 1;
+    }
+    if (fread(magic, 1, 4, fd) != 4 || memcmp(magic, TRACE_FILE_MAGIC, 4) != 0 || fread(&version, sizeof(version), 1, fd) != 1 || version != TRACE_FILE_VERSION)
+    {
+        printf("ERROR: %s is not a version %d trace file\n", trace_file, TRACE_FILE_VERSION);
+        fclose(fd);
+        return 1;
+    }
+
+    while (valid && fread(&id, 2, 1, fd) == 1)
+    {
+        const char *c;
+        int arg = 0;
+
+        if (id == TRACE_FORMAT_DEFINITION)
+        {
+            valid = fread(&id, 2, 1, fd) == 1 && fread(&length, 2, 1, fd) == 1 && id < TRACE_FORMAT_SLOTS;
+            if (valid)
+            {
+                free(formats[id]);
+                formats[id] = (char *)malloc(length + 1);
+                valid = fread(formats[id], 1, length, fd) == length;
+                formats[id][length] = '\0';
+            }
+            continue;
+        }
+
+        if (id >= TRACE_FORMAT_SLOTS || formats[id] == NULL)
+        {
+            valid = 0;
+            break;
+        }
+
+        parse_trace_format(formats[id], arg_types);
+        c = formats[id];
+        while (*c != '\0' && valid)
+        {
+            const char *start = c;
+            size_t spec_length;
+
+            if (*c != '%')
+            {
+                fputc(*c++, output);
+                continue;
+            }
+            if (c[1] == '%')
+            {
+                fputc('%', output);
+                c += 2;
+                continue;
+            }
+
+            //Copy the conversion, so that it is printed with the same flags, width and precision.
+            c++;
+            while (*c != '\0' && strchr("-+ #0123456789.lh", *c) != NULL)
+                c++;
+            c++;
+            spec_length = c - start;
+            if (spec_length >= sizeof(spec))
+                spec_length = sizeof(spec) - 1;
+            memcpy(spec, start, spec_length);
+            spec[spec_length] = '\0';
+
+            switch (arg_types[arg++])
+            {
+            case 'i':
+            {
+                int32_t value;
+                valid = fread(&value, sizeof(value), 1, fd) == 1;
+                fprintf(output, spec, (int)value);
+                break;
+            }
+            case 'l':
+            {
+                int64_t value;
+                valid = fread(&value, sizeof(value), 1, fd) == 1;
+                fprintf(output, spec, (long)value);
+                break;
+            }
+            case 'f':
+            {
+                double value;
+                valid = fread(&value, sizeof(value), 1, fd) == 1;
+                fprintf(output, spec, value);
+                break;
+            }
+            case 's':
+            {
+                unsigned char string_length;
+                valid = fread(&string_length, 1, 1, fd) == 1 && fread(string, 1, string_length, fd) == string_length;
+                string[valid ? string_length : 0] = '\0';
+                fprintf(output, spec, string);
+                break;
+            }
+            }
+        }
+    }
+
+    if (!valid)
+        printf("ERROR: Trace file %s is truncated or corrupt\n", trace_file);
+
+    for (i = 0; i < TRACE_FORMAT_SLOTS; i++)
+    {
+        free(formats[i]);
+    }
+    fclose(fd);
+
+    return !valid;
+}